@@ -0,0 +1,215 @@
+#include <lars/any.h>
+#include <lars/any_function.h>
+
+#include <any>
+#include <functional>
+#include <string>
+#include <utility>
+#include <variant>
+#include <benchmark/benchmark.h>
+
+namespace any_benchmark {
+  using Variant = std::variant<int, double, std::string>;
+
+  struct ToDouble {
+    double operator()(int v) const { return v; }
+    double operator()(double v) const { return v; }
+    double operator()(const std::string &) const { throw std::bad_variant_access(); }
+  };
+
+  int add(int a, int b, int c) { return a + b + c; }
+
+  /**
+   * Calls `f` with the first `Arity` arguments of `(1, 2, 3)`.
+   */
+  template <size_t Arity, class F> auto callWithArity(const F & f) {
+    if constexpr (Arity == 0) { return f(); }
+    else if constexpr (Arity == 1) { return f(1); }
+    else if constexpr (Arity == 2) { return f(1, 2); }
+    else { return f(1, 2, 3); }
+  }
+
+  template <size_t Arity> auto makeCallback() {
+    if constexpr (Arity == 0) { return std::function<int()>([](){ return add(0, 0, 0); }); }
+    else if constexpr (Arity == 1) { return std::function<int(int)>([](int a){ return add(a, 0, 0); }); }
+    else if constexpr (Arity == 2) { return std::function<int(int, int)>([](int a, int b){ return add(a, b, 0); }); }
+    else { return std::function<int(int, int, int)>(add); }
+  }
+}
+
+// ---- set and get ----
+
+static void AnySetGet(benchmark::State& state) {
+  lars::Any any;
+  int i = 0;
+  for (auto _ : state) {
+    any = i++;
+    benchmark::DoNotOptimize(any.get<int>());
+  }
+}
+
+static void AnyAssignGet(benchmark::State& state) {
+  lars::Any any = 0;
+  int i = 0;
+  for (auto _ : state) {
+    any.assign<int>(i++);
+    benchmark::DoNotOptimize(any.get<int>());
+  }
+}
+
+static void StdAnySetGet(benchmark::State& state) {
+  std::any any;
+  int i = 0;
+  for (auto _ : state) {
+    any = i++;
+    benchmark::DoNotOptimize(std::any_cast<int>(any));
+  }
+}
+
+static void VariantSetGet(benchmark::State& state) {
+  any_benchmark::Variant variant;
+  int i = 0;
+  for (auto _ : state) {
+    variant = i++;
+    benchmark::DoNotOptimize(std::get<int>(variant));
+  }
+}
+
+// ---- copy ----
+
+static void AnyReferenceCopy(benchmark::State& state) {
+  lars::Any any = std::string("a string that does not fit into small buffers");
+  for (auto _ : state) {
+    lars::AnyReference copy = any;
+    benchmark::DoNotOptimize(copy);
+  }
+}
+
+static void StdAnyCopy(benchmark::State& state) {
+  std::any any = std::string("a string that does not fit into small buffers");
+  for (auto _ : state) {
+    std::any copy = any;
+    benchmark::DoNotOptimize(copy);
+  }
+}
+
+static void VariantCopy(benchmark::State& state) {
+  any_benchmark::Variant variant = std::string("a string that does not fit into small buffers");
+  for (auto _ : state) {
+    any_benchmark::Variant copy = variant;
+    benchmark::DoNotOptimize(copy);
+  }
+}
+
+// ---- numeric conversions ----
+
+static void AnyNumericConversion(benchmark::State& state) {
+  lars::Any any = 42;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(any.get<double>());
+  }
+}
+
+static void VariantNumericConversion(benchmark::State& state) {
+  any_benchmark::Variant variant = 42;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(std::visit(any_benchmark::ToDouble(), variant));
+  }
+}
+
+// ---- function calls ----
+
+template <size_t Arity> static void AnyFunctionCall(benchmark::State& state) {
+  lars::AnyFunction f = any_benchmark::makeCallback<Arity>();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(any_benchmark::callWithArity<Arity>(f));
+  }
+}
+
+template <size_t Arity> static void AnyFunctionCallInto(benchmark::State& state) {
+  lars::AnyFunction f = any_benchmark::makeCallback<Arity>();
+  lars::AnyArguments args;
+  for (size_t i = 0; i < Arity; ++i) { args.emplace_back(int(i + 1)); }
+  lars::Any result;
+  for (auto _ : state) {
+    f.call(args, result);
+    benchmark::DoNotOptimize(result);
+  }
+}
+
+template <size_t Arity> static void StdFunctionCall(benchmark::State& state) {
+  auto f = any_benchmark::makeCallback<Arity>();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(any_benchmark::callWithArity<Arity>(f));
+  }
+}
+
+static void AnyFunctionVariadicCall(benchmark::State& state) {
+  lars::AnyFunction f = [](const lars::AnyArguments &args){
+    int sum = 0;
+    for (auto & arg: args) { sum += arg.get<int>(); }
+    return sum;
+  };
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f(1, 2, 3));
+  }
+}
+
+// ---- misses ----
+
+static void AnyInvalidCast(benchmark::State& state) {
+  lars::Any any = 42;
+  for (auto _ : state) {
+    try {
+      benchmark::DoNotOptimize(any.get<const std::string &>());
+    } catch (lars::InvalidVisitorException &e) {
+      benchmark::DoNotOptimize(e.what());
+    }
+  }
+}
+
+static void AnyTryGetMiss(benchmark::State& state) {
+  lars::Any any = 42;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(any.tryGet<std::string>());
+  }
+}
+
+static void StdAnyInvalidCast(benchmark::State& state) {
+  std::any any = 42;
+  for (auto _ : state) {
+    try {
+      benchmark::DoNotOptimize(std::any_cast<const std::string &>(any));
+    } catch (std::bad_any_cast &e) {
+      benchmark::DoNotOptimize(e.what());
+    }
+  }
+}
+
+BENCHMARK(AnySetGet);
+BENCHMARK(AnyAssignGet);
+BENCHMARK(StdAnySetGet);
+BENCHMARK(VariantSetGet);
+
+BENCHMARK(AnyReferenceCopy);
+BENCHMARK(StdAnyCopy);
+BENCHMARK(VariantCopy);
+
+BENCHMARK(AnyNumericConversion);
+BENCHMARK(VariantNumericConversion);
+
+BENCHMARK_TEMPLATE(AnyFunctionCall, 0);
+BENCHMARK_TEMPLATE(AnyFunctionCall, 1);
+BENCHMARK_TEMPLATE(AnyFunctionCall, 2);
+BENCHMARK_TEMPLATE(AnyFunctionCall, 3);
+BENCHMARK_TEMPLATE(AnyFunctionCallInto, 0);
+BENCHMARK_TEMPLATE(AnyFunctionCallInto, 3);
+BENCHMARK_TEMPLATE(StdFunctionCall, 0);
+BENCHMARK_TEMPLATE(StdFunctionCall, 1);
+BENCHMARK_TEMPLATE(StdFunctionCall, 2);
+BENCHMARK_TEMPLATE(StdFunctionCall, 3);
+BENCHMARK(AnyFunctionVariadicCall);
+
+BENCHMARK(AnyInvalidCast);
+BENCHMARK(AnyTryGetMiss);
+BENCHMARK(StdAnyInvalidCast);
@@ -0,0 +1,87 @@
+/**
+ * Benchmarks of readers of a value published to many threads. `AtomicAny` is compared to an
+ * `AnyReference` guarded by a `std::mutex` and by a `std::shared_mutex`. The `items_per_thread`
+ * counter reports the throughput of a single reader.
+ */
+
+#include <lars/atomic_any.h>
+
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <benchmark/benchmark.h>
+
+namespace atomic_any {
+
+  const lars::Any & value() {
+    static const lars::Any value = std::string("a published configuration");
+    return value;
+  }
+
+  lars::AtomicAny & atomic() {
+    static lars::AtomicAny atomic{lars::AnyReference(value())};
+    return atomic;
+  }
+
+  template <class Mutex> struct Guarded {
+    Mutex mutex;
+    lars::AnyReference value = atomic_any::value();
+  };
+
+  template <class Mutex> Guarded<Mutex> & guarded() {
+    static Guarded<Mutex> guarded;
+    return guarded;
+  }
+
+  void setThroughput(benchmark::State& state) {
+    state.counters["items_per_thread"] = benchmark::Counter(double(state.iterations()), benchmark::Counter::kAvgThreadsRate);
+  }
+
+}
+
+static void AtomicAnyLoad(benchmark::State& state) {
+  auto & atomic = atomic_any::atomic();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(atomic.load().get<const std::string &>().size());
+  }
+  atomic_any::setThroughput(state);
+}
+
+static void AtomicAnyRead(benchmark::State& state) {
+  auto & atomic = atomic_any::atomic();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(atomic.read([](const lars::Any &v){ return v.get<const std::string &>().size(); }));
+  }
+  atomic_any::setThroughput(state);
+}
+
+static void MutexAnyLoad(benchmark::State& state) {
+  auto & guarded = atomic_any::guarded<std::mutex>();
+  for (auto _ : state) {
+    lars::AnyReference value;
+    {
+      std::lock_guard<std::mutex> lock(guarded.mutex);
+      value = guarded.value;
+    }
+    benchmark::DoNotOptimize(value.get<const std::string &>().size());
+  }
+  atomic_any::setThroughput(state);
+}
+
+static void SharedMutexAnyLoad(benchmark::State& state) {
+  auto & guarded = atomic_any::guarded<std::shared_mutex>();
+  for (auto _ : state) {
+    lars::AnyReference value;
+    {
+      std::shared_lock<std::shared_mutex> lock(guarded.mutex);
+      value = guarded.value;
+    }
+    benchmark::DoNotOptimize(value.get<const std::string &>().size());
+  }
+  atomic_any::setThroughput(state);
+}
+
+BENCHMARK(AtomicAnyLoad)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(AtomicAnyRead)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(MutexAnyLoad)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(SharedMutexAnyLoad)->ThreadRange(1, 64)->UseRealTime();
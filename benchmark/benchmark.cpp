@@ -1,6 +1,13 @@
 #include <lars/visitor.h>
+#include <lars/bi_visitor.h>
+#include <lars/type_map.h>
 
+#include <algorithm>
 #include <memory>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 #include <benchmark/benchmark.h>
 
 namespace classic {
@@ -146,6 +153,165 @@ static void DynamicCast(benchmark::State& state) {
   }
 }
 
+namespace double_dispatch {
+  using namespace visitor;
+
+  template <class First> struct InnerVisitor: public lars::Visitor<const B &, const E &> {
+    const First * first;
+    char result;
+    InnerVisitor(const First &f):first(&f){ }
+    void visit(const B &b)override{ result = first->a + b.b; }
+    void visit(const E &e)override{ result = first->a + e.e; }
+  };
+
+  struct OuterVisitor: public lars::Visitor<const B &, const E &> {
+    const lars::VisitableBase * second;
+    char result;
+    template <class First> void visitSecond(const First &first) {
+      InnerVisitor<First> inner(first);
+      second->accept(inner);
+      result = inner.result;
+    }
+    void visit(const B &b)override{ visitSecond(b); }
+    void visit(const E &e)override{ visitSecond(e); }
+  };
+
+  char __attribute__ ((noinline)) getNestedValue (const A & a, const A & b){
+    OuterVisitor visitor;
+    visitor.second = &b;
+    a.accept(visitor);
+    return visitor.result;
+  }
+
+  struct PairVisitor: public lars::BiVisitor<
+    lars::TypeList<const B &, const B &>,
+    lars::TypeList<const B &, const E &>,
+    lars::TypeList<const E &, const B &>,
+    lars::TypeList<const E &, const E &>
+  > {
+    char result;
+    void visit(const B &a, const B &b)override{ result = a.a + b.b; }
+    void visit(const B &a, const E &e)override{ result = a.a + e.e; }
+    void visit(const E &a, const B &b)override{ result = a.a + b.b; }
+    void visit(const E &a, const E &e)override{ result = a.a + e.e; }
+  };
+
+  char __attribute__ ((noinline)) getPairValue (PairVisitor & visitor, const A & a, const A & b){
+    lars::visit2(a, b, visitor);
+    return visitor.result;
+  }
+}
+
+namespace type_map {
+  template <size_t I> struct Key {};
+
+  template <size_t ... I> std::vector<lars::StaticTypeIndex> makeKeys(std::index_sequence<I...>) {
+    return std::vector<lars::StaticTypeIndex>{ lars::getStaticTypeIndex<Key<I>>()... };
+  }
+
+  const std::vector<lars::StaticTypeIndex> & getKeys() {
+    static auto keys = makeKeys(std::make_index_sequence<10000>());
+    return keys;
+  }
+
+  /**
+   * The first `count` keys in a random order, used as lookup sequence.
+   */
+  std::vector<lars::StaticTypeIndex> getLookups(size_t count) {
+    auto & keys = getKeys();
+    std::vector<lars::StaticTypeIndex> lookups(keys.begin(), keys.begin() + count);
+    std::shuffle(lookups.begin(), lookups.end(), std::mt19937(42));
+    return lookups;
+  }
+
+  template <class Map> void fill(Map & map, size_t count) {
+    auto & keys = getKeys();
+    for (size_t i = 0; i < count; ++i) { map[keys[i]] = i; }
+  }
+
+  template <class Map> size_t lookup(const Map & map, const lars::StaticTypeIndex & key) {
+    if constexpr (std::is_same<Map, lars::TypeMap<size_t>>::value) {
+      return *map.find(key);
+    } else {
+      return map.find(key)->second;
+    }
+  }
+
+  template <class Map> void benchmarkLookup(benchmark::State& state, Map & map) {
+    auto count = size_t(state.range(0));
+    fill(map, count);
+    auto lookups = getLookups(count);
+    size_t i = 0;
+    for (auto _ : state) {
+      benchmark::DoNotOptimize(lookup(map, lookups[i]));
+      if (++i == lookups.size()) { i = 0; }
+    }
+  }
+}
+
+static void NestedDoubleDispatch(benchmark::State& state) {
+  using namespace visitor;
+  std::shared_ptr<A> b = std::make_shared<B>();
+  std::shared_ptr<A> d = std::make_shared<D>();
+  std::shared_ptr<A> e = std::make_shared<E>();
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Assert(double_dispatch::getNestedValue(*b, *e) == char('a' + 'E')));
+    benchmark::DoNotOptimize(Assert(double_dispatch::getNestedValue(*d, *b) == char('D' + 'B')));
+    benchmark::DoNotOptimize(Assert(double_dispatch::getNestedValue(*e, *d) == char('a' + 'D')));
+  }
+}
+
+static void BiVisitorDispatch(benchmark::State& state) {
+  using namespace visitor;
+  std::shared_ptr<A> b = std::make_shared<B>();
+  std::shared_ptr<A> d = std::make_shared<D>();
+  std::shared_ptr<A> e = std::make_shared<E>();
+  double_dispatch::PairVisitor visitor;
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(Assert(double_dispatch::getPairValue(visitor, *b, *e) == char('a' + 'E')));
+    benchmark::DoNotOptimize(Assert(double_dispatch::getPairValue(visitor, *d, *b) == char('D' + 'B')));
+    benchmark::DoNotOptimize(Assert(double_dispatch::getPairValue(visitor, *e, *d) == char('a' + 'D')));
+  }
+}
+
+static void BiVisitorDispatchNewVisitor(benchmark::State& state) {
+  using namespace visitor;
+  std::shared_ptr<A> b = std::make_shared<B>();
+  std::shared_ptr<A> d = std::make_shared<D>();
+  std::shared_ptr<A> e = std::make_shared<E>();
+
+  for (auto _ : state) {
+    double_dispatch::PairVisitor visitor;
+    benchmark::DoNotOptimize(Assert(double_dispatch::getPairValue(visitor, *b, *e) == char('a' + 'E')));
+    benchmark::DoNotOptimize(Assert(double_dispatch::getPairValue(visitor, *d, *b) == char('D' + 'B')));
+    benchmark::DoNotOptimize(Assert(double_dispatch::getPairValue(visitor, *e, *d) == char('a' + 'D')));
+  }
+}
+
+static void UnorderedMapLookup(benchmark::State& state) {
+  std::unordered_map<lars::StaticTypeIndex, size_t> map;
+  type_map::benchmarkLookup(state, map);
+}
+
+static void TypeMapLookup(benchmark::State& state) {
+  lars::TypeMap<size_t> map;
+  type_map::benchmarkLookup(state, map);
+}
+
+static void FrozenTypeMapLookup(benchmark::State& state) {
+  lars::TypeMap<size_t> map;
+  type_map::fill(map, size_t(state.range(0)));
+  map.freeze();
+  auto lookups = type_map::getLookups(size_t(state.range(0)));
+  size_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(*map.find(lookups[i]));
+    if (++i == lookups.size()) { i = 0; }
+  }
+}
+
 BENCHMARK(ClassicVisitor);
 BENCHMARK(LarsVisitor);
 BENCHMARK(DynamicVisitor);
@@ -153,4 +319,12 @@ BENCHMARK(DynamicVisitor);
 BENCHMARK(VisitorCast);
 BENCHMARK(DynamicCast);
 
+BENCHMARK(NestedDoubleDispatch);
+BENCHMARK(BiVisitorDispatch);
+BENCHMARK(BiVisitorDispatchNewVisitor);
+
+BENCHMARK(UnorderedMapLookup)->Arg(10)->Arg(100)->Arg(10000);
+BENCHMARK(TypeMapLookup)->Arg(10)->Arg(100)->Arg(10000);
+BENCHMARK(FrozenTypeMapLookup)->Arg(10)->Arg(100)->Arg(10000);
+
 BENCHMARK_MAIN();
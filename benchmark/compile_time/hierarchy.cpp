@@ -0,0 +1,49 @@
+/**
+ * A generated visitable hierarchy used to measure compile times.
+ * Every level contains LARS_BENCHMARK_WIDTH types, each virtually derived from two types of
+ * the previous level. The hierarchy has LARS_BENCHMARK_DEPTH levels.
+ */
+
+#include <lars/visitor.h>
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+#ifndef LARS_BENCHMARK_DEPTH
+#define LARS_BENCHMARK_DEPTH 4
+#endif
+
+#ifndef LARS_BENCHMARK_WIDTH
+#define LARS_BENCHMARK_WIDTH 4
+#endif
+
+constexpr unsigned depth = LARS_BENCHMARK_DEPTH;
+constexpr unsigned width = LARS_BENCHMARK_WIDTH;
+
+template <unsigned Level, unsigned Index> struct Node;
+
+template <unsigned Index> struct Node<0, Index>: public lars::Visitable<Node<0, Index>> {
+  unsigned value = Index;
+};
+
+template <unsigned Level, unsigned Index> struct Node: public lars::DerivedVisitable<
+  Node<Level, Index>,
+  lars::VirtualVisitable<Node<Level - 1, Index>, Node<Level - 1, (Index + 1) % width>>
+> {
+  unsigned value = Level * width + Index;
+};
+
+template <unsigned ... Indices> unsigned visitAll(std::integer_sequence<unsigned, Indices...>) {
+  std::vector<std::shared_ptr<lars::VisitableBase>> nodes{ std::make_shared<Node<depth - 1, Indices>>()... };
+  unsigned result = 0;
+  for (auto &node: nodes) {
+    if (auto base = lars::visitor_cast<Node<0, 0> *>(node.get())) { result += base->value; }
+    result += lars::isA<Node<0, width - 1>>(*node);
+  }
+  return result;
+}
+
+int main() {
+  return int(visitAll(std::make_integer_sequence<unsigned, width>()) == 0);
+}
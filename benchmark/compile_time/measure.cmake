@@ -0,0 +1,63 @@
+# Compiles benchmark/compile_time/hierarchy.cpp for every combination of DEPTHS and WIDTHS
+# and records the compile time and object size of each run in RESULTS as CSV.
+# Invoked by the LarsVisitorCompileTimeBenchmark target, see CMakeLists.txt.
+
+cmake_minimum_required (VERSION 3.14)
+
+foreach(variable COMPILER SOURCE WORKING_DIRECTORY DEPTHS WIDTHS RESULTS)
+  if(NOT DEFINED ${variable})
+    message(FATAL_ERROR "measure.cmake: ${variable} is not set")
+  endif()
+endforeach()
+
+string(REPLACE "|" ";" DEPTHS "${DEPTHS}")
+string(REPLACE "|" ";" WIDTHS "${WIDTHS}")
+string(REPLACE "|" ";" INCLUDE_DIRECTORIES "${INCLUDE_DIRECTORIES}")
+separate_arguments(FLAGS UNIX_COMMAND "${FLAGS}")
+
+set(include_flags)
+foreach(directory ${INCLUDE_DIRECTORIES})
+  list(APPEND include_flags "-I${directory}")
+endforeach()
+
+# microsecond timestamps require CMake 3.23, older versions measure whole seconds
+if(CMAKE_VERSION VERSION_LESS 3.23)
+  set(timestamp_format "%s000000")
+else()
+  set(timestamp_format "%s%f")
+endif()
+
+file(MAKE_DIRECTORY "${WORKING_DIRECTORY}")
+file(WRITE "${RESULTS}" "depth,width,types,seconds,object_bytes\n")
+
+foreach(depth ${DEPTHS})
+  foreach(width ${WIDTHS})
+    set(object "${WORKING_DIRECTORY}/hierarchy_${depth}_${width}.o")
+    math(EXPR types "${depth} * ${width}")
+
+    string(TIMESTAMP start "${timestamp_format}" UTC)
+    execute_process(
+      COMMAND ${COMPILER} ${FLAGS} ${include_flags}
+        -DLARS_BENCHMARK_DEPTH=${depth} -DLARS_BENCHMARK_WIDTH=${width}
+        -c ${SOURCE} -o ${object}
+      RESULT_VARIABLE result
+    )
+    string(TIMESTAMP end "${timestamp_format}" UTC)
+
+    if(NOT result EQUAL 0)
+      message(FATAL_ERROR "compiling hierarchy with depth ${depth} and width ${width} failed")
+    endif()
+
+    math(EXPR microseconds "${end} - ${start}")
+    math(EXPR milliseconds "${microseconds} / 1000")
+    math(EXPR seconds "${milliseconds} / 1000")
+    math(EXPR fraction "${milliseconds} % 1000 + 1000")
+    string(SUBSTRING "${fraction}" 1 3 fraction)
+    file(SIZE "${object}" object_bytes)
+
+    message(STATUS "depth ${depth}, width ${width}: ${seconds}.${fraction} s, ${object_bytes} bytes")
+    file(APPEND "${RESULTS}" "${depth},${width},${types},${seconds}.${fraction},${object_bytes}\n")
+  endforeach()
+endforeach()
+
+message(STATUS "results written to ${RESULTS}")
@@ -0,0 +1,77 @@
+/**
+ * Benchmarks of `Any` objects shared between threads. Copies of `AnyReference` and calls to
+ * `Any::getShared` modify the reference count of the shared storage, which is contended when
+ * many threads access the same object. The `items_per_thread` counter reports the throughput
+ * of a single thread, so a drop with increasing thread count indicates contention.
+ */
+
+#include <lars/any.h>
+#include <lars/any_function.h>
+
+#include <memory>
+#include <string>
+#include <benchmark/benchmark.h>
+
+namespace contention {
+
+  /**
+   * The object shared by all threads.
+   */
+  const lars::Any & shared() {
+    static const lars::Any value = std::string("a string shared between threads");
+    return value;
+  }
+
+  void setThroughput(benchmark::State& state) {
+    state.counters["items_per_thread"] = benchmark::Counter(double(state.iterations()), benchmark::Counter::kAvgThreadsRate);
+  }
+
+}
+
+static void SharedAnyGet(benchmark::State& state) {
+  auto & any = contention::shared();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(any.get<const std::string &>());
+  }
+  contention::setThroughput(state);
+}
+
+static void SharedAnyGetShared(benchmark::State& state) {
+  auto & any = contention::shared();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(any.getShared<const std::string>());
+  }
+  contention::setThroughput(state);
+}
+
+static void LocalAnyGetShared(benchmark::State& state) {
+  lars::Any any = std::string("a string owned by a single thread");
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(any.getShared<const std::string>());
+  }
+  contention::setThroughput(state);
+}
+
+static void SharedAnyReferenceCall(benchmark::State& state) {
+  auto & any = contention::shared();
+  lars::AnyFunction f = [](const std::string &value){ return value.size(); };
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f(any));
+  }
+  contention::setThroughput(state);
+}
+
+static void LocalAnyReferenceCall(benchmark::State& state) {
+  lars::Any any = std::string("a string owned by a single thread");
+  lars::AnyFunction f = [](const std::string &value){ return value.size(); };
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(f(any));
+  }
+  contention::setThroughput(state);
+}
+
+BENCHMARK(SharedAnyGet)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(SharedAnyGetShared)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(LocalAnyGetShared)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(SharedAnyReferenceCall)->ThreadRange(1, 64)->UseRealTime();
+BENCHMARK(LocalAnyReferenceCall)->ThreadRange(1, 64)->UseRealTime();
@@ -0,0 +1,123 @@
+/**
+ * Benchmarks of `EventBus`. Throughput is compared to broadcasting every message to every
+ * subscriber, which filters by calling `tryGet`. The latency benchmark publishes timestamped
+ * messages to a subscriber polling on another thread and reports the 50th, 99th and 99.9th
+ * percentile of the delivery time in nanoseconds.
+ */
+
+#include <lars/event_bus.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+#include <vector>
+#include <benchmark/benchmark.h>
+
+namespace event_bus {
+
+  struct Message: public lars::Visitable<Message> {
+    uint64_t time = 0;
+  };
+
+  struct Other: public lars::Visitable<Other> { };
+
+  uint64_t now() {
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+  }
+
+  /**
+   * Subscribes `count - 1` subscribers to `Other` and one to `Message`, which is returned.
+   */
+  std::shared_ptr<lars::EventBus::Subscriber> subscribe(lars::EventBus &bus, size_t count, std::vector<std::shared_ptr<lars::EventBus::Subscriber>> &others, size_t &received) {
+    for (size_t i = 1; i < count; ++i) {
+      others.push_back(bus.subscribe<const Other &>([](const Other &){ }));
+    }
+    return bus.subscribe<const Message &>([&](const Message &){ ++received; });
+  }
+
+}
+
+static void EventBusPublish(benchmark::State& state) {
+  lars::EventBus bus;
+  std::vector<std::shared_ptr<lars::EventBus::Subscriber>> others;
+  size_t received = 0;
+  auto subscriber = event_bus::subscribe(bus, size_t(state.range(0)), others, received);
+  lars::Any message = event_bus::Message();
+  for (auto _ : state) {
+    bus.publish(message);
+    subscriber->poll();
+  }
+  benchmark::DoNotOptimize(received);
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void EventBusBatchPublish(benchmark::State& state) {
+  lars::EventBus bus;
+  std::vector<std::shared_ptr<lars::EventBus::Subscriber>> others;
+  size_t received = 0;
+  auto subscriber = event_bus::subscribe(bus, size_t(state.range(0)), others, received);
+  std::vector<lars::Any> messages(64);
+  for (auto &message: messages) { message = event_bus::Message(); }
+  for (auto _ : state) {
+    bus.publish(messages.begin(), messages.end());
+    subscriber->poll();
+  }
+  benchmark::DoNotOptimize(received);
+  state.SetItemsProcessed(state.iterations() * int64_t(messages.size()));
+}
+
+static void BroadcastTryGet(benchmark::State& state) {
+  size_t received = 0;
+  std::vector<std::function<void(const lars::Any &)>> subscribers;
+  for (int64_t i = 1; i < state.range(0); ++i) {
+    subscribers.emplace_back([](const lars::Any &value){ benchmark::DoNotOptimize(value.tryGet<const event_bus::Other>()); });
+  }
+  subscribers.emplace_back([&](const lars::Any &value){ if (value.tryGet<const event_bus::Message>()) { ++received; } });
+  lars::Any message = event_bus::Message();
+  for (auto _ : state) {
+    for (auto &subscriber: subscribers) { subscriber(message); }
+  }
+  benchmark::DoNotOptimize(received);
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void EventBusLatency(benchmark::State& state) {
+  lars::EventBus bus;
+  std::vector<uint64_t> latencies;
+  latencies.reserve(1 << 20);
+  auto subscriber = bus.subscribe<const event_bus::Message &>([&](const event_bus::Message &message){
+    if (latencies.size() < latencies.capacity()) { latencies.push_back(event_bus::now() - message.time); }
+  });
+  std::atomic<bool> stop{false};
+  std::thread consumer([&](){
+    while (!stop) {
+      if (!subscriber->poll(64)) { std::this_thread::yield(); }
+    }
+    subscriber->poll();
+  });
+
+  for (auto _ : state) {
+    lars::Any message = event_bus::Message();
+    message.get<event_bus::Message &>().time = event_bus::now();
+    bus.publish(message);
+  }
+  stop = true;
+  consumer.join();
+
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p){
+    return latencies.empty() ? 0.0 : double(latencies[std::min(latencies.size() - 1, size_t(p * double(latencies.size())))]);
+  };
+  state.counters["p50_ns"] = percentile(0.5);
+  state.counters["p99_ns"] = percentile(0.99);
+  state.counters["p999_ns"] = percentile(0.999);
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(EventBusPublish)->Arg(1)->Arg(8)->Arg(64);
+BENCHMARK(EventBusBatchPublish)->Arg(1)->Arg(8)->Arg(64);
+BENCHMARK(BroadcastTryGet)->Arg(1)->Arg(8)->Arg(64);
+BENCHMARK(EventBusLatency)->UseRealTime();
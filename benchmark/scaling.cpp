@@ -0,0 +1,149 @@
+/**
+ * Generated benchmarks measuring how the cost of `accept` scales with
+ *  - the number of types handled by a visitor (width),
+ *  - the depth of `DerivedVisitable` chains,
+ *  - the number of bases joined by a `JoinVisitable` (fan-in).
+ * Every family is measured for a hit of the first and the last candidate as well as for a
+ * miss, with both `Visitor` and `RecursiveVisitor`.
+ * Run with `--benchmark_out=<file> --benchmark_out_format=json` to record the results.
+ */
+
+#include <lars/visitor.h>
+
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <benchmark/benchmark.h>
+
+namespace scaling {
+  using namespace lars;
+
+  template <size_t I> struct Leaf: public Visitable<Leaf<I>> { };
+
+  template <size_t D> struct Chain: public DerivedVisitable<Chain<D>, Chain<D - 1>> { };
+  template <> struct Chain<0>: public Visitable<Chain<0>> { };
+
+  /**
+   * A type that is not handled by any visitor.
+   */
+  using Unrelated = Leaf<size_t(-1)>;
+
+  template <size_t ... I> using Join = JoinVisitable<Leaf<I>...>;
+
+  size_t hits = 0;
+
+  /**
+   * Visit methods for the benchmark types. They are provided through specializations of
+   * `SingleVisitor` and `SingleRecursiveVisitor`, as implementing hundreds of visit methods
+   * in a derived class is not feasible. Recursive visitors stop at the first hit.
+   */
+  template <class T> struct CountingVisit: public SingleVisitorBase {
+    virtual void visit(T) { ++hits; }
+  };
+
+  template <class T> struct CountingRecursiveVisit: public SingleRecursiveVisitorBase {
+    virtual bool visit(T) { ++hits; return true; }
+  };
+}
+
+namespace lars {
+  template <size_t I> class SingleVisitor<scaling::Leaf<I> &>: public scaling::CountingVisit<scaling::Leaf<I> &> { };
+  template <size_t D> class SingleVisitor<scaling::Chain<D> &>: public scaling::CountingVisit<scaling::Chain<D> &> { };
+  template <size_t I> class SingleRecursiveVisitor<scaling::Leaf<I> &>: public scaling::CountingRecursiveVisit<scaling::Leaf<I> &> { };
+  template <size_t D> class SingleRecursiveVisitor<scaling::Chain<D> &>: public scaling::CountingRecursiveVisit<scaling::Chain<D> &> { };
+}
+
+namespace scaling {
+
+  /**
+   * Counts misses, which are reported by `visitDefault` for regular visitors and by the
+   * return value of `accept` for recursive visitors.
+   */
+  template <class Base> struct Counting: public Base {
+    size_t misses = 0;
+    void visitDefault(const VisitableBase &) override { ++misses; }
+  };
+
+  template <class List> struct Visitors;
+  template <typename ... Types> struct Visitors<TypeList<Types...>> {
+    using Regular = Counting<Visitor<Types...>>;
+    using Recursive = Counting<RecursiveVisitor<Types...>>;
+  };
+
+  void __attribute__ ((noinline)) acceptOnce(VisitableBase &visitable, VisitorBase &visitor) {
+    visitable.accept(visitor);
+  }
+
+  bool __attribute__ ((noinline)) acceptOnce(VisitableBase &visitable, RecursiveVisitorBase &visitor) {
+    return visitable.accept(visitor);
+  }
+
+  template <class V, class O> void accept(benchmark::State& state) {
+    O object;
+    V visitor;
+    VisitableBase *visitable = &object;
+    benchmark::DoNotOptimize(visitable);
+    for (auto _ : state) {
+      if constexpr (std::is_base_of<VisitorBase, V>::value) {
+        acceptOnce(*visitable, visitor);
+      } else {
+        visitor.misses += !acceptOnce(*visitable, visitor);
+      }
+    }
+    benchmark::DoNotOptimize(hits);
+    benchmark::DoNotOptimize(visitor.misses);
+  }
+
+  /**
+   * Registers the benchmarks of an object of type `O` accepting visitors of `Types`.
+   * The benchmarks are named `<family>/<visitor>/<kind>/<value>` and report `value` as the
+   * counter `param`.
+   */
+  template <class Types, class O> void registerCase(const std::string &family, const std::string &kind, const char * param, size_t value) {
+    auto add = [&](const std::string &visitorName, auto function){
+      auto name = family + "/" + visitorName + "/" + kind + "/" + std::to_string(value);
+      benchmark::RegisterBenchmark(name.c_str(), [=](benchmark::State& state){
+        function(state);
+        state.counters[param] = double(value);
+      });
+    };
+    add("Visitor", &accept<typename Visitors<Types>::Regular, O>);
+    add("RecursiveVisitor", &accept<typename Visitors<Types>::Recursive, O>);
+  }
+
+  template <size_t ... I> void registerWidth(std::index_sequence<I...>) {
+    constexpr size_t N = sizeof...(I);
+    using Types = TypeList<Leaf<I> &...>;
+    registerCase<Types, Leaf<0>>("Width", "hitFirst", "types", N);
+    registerCase<Types, Leaf<N - 1>>("Width", "hitLast", "types", N);
+    registerCase<Types, Leaf<N>>("Width", "miss", "types", N);
+  }
+
+  template <size_t D> void registerDepth() {
+    using O = Chain<D - 1>;
+    registerCase<TypeList<Chain<D - 1> &>, O>("Depth", "hitFirst", "depth", D);
+    registerCase<TypeList<Chain<0> &>, O>("Depth", "hitLast", "depth", D);
+    registerCase<TypeList<Unrelated &>, O>("Depth", "miss", "depth", D);
+  }
+
+  template <size_t ... I> void registerFanIn(std::index_sequence<I...>) {
+    constexpr size_t K = sizeof...(I);
+    using O = Join<I...>;
+    registerCase<TypeList<Leaf<0> &>, O>("FanIn", "hitFirst", "bases", K);
+    registerCase<TypeList<Leaf<K - 1> &>, O>("FanIn", "hitLast", "bases", K);
+    registerCase<TypeList<Unrelated &>, O>("FanIn", "miss", "bases", K);
+  }
+
+  template <size_t ... N> void registerWidths() { (registerWidth(std::make_index_sequence<N>()), ...); }
+  template <size_t ... D> void registerDepths() { (registerDepth<D>(), ...); }
+  template <size_t ... K> void registerFanIns() { (registerFanIn(std::make_index_sequence<K>()), ...); }
+
+  const bool registered = [](){
+    registerWidths<1, 4, 16, 64, 256>();
+    registerDepths<1, 4, 8, 16, 32>();
+    registerFanIns<2, 4, 8, 16, 32>();
+    return true;
+  }();
+}
+
+BENCHMARK_MAIN();
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <lars/any_accounting.h>
 #include <lars/visitor.h>
 
 #include <string>
+#include <string_view>
 #include <memory>
 #include <exception>
 #include <functional>
@@ -22,6 +24,8 @@ namespace lars {
   
   class Any;
   struct AnyReference;
+  class AtomicAny;
+  template <typename ... Pairs> class BiVisitor;
   
   namespace any_detail {
     template<typename T> struct is_shared_ptr : std::false_type { using value_type = void; };
@@ -30,11 +34,43 @@ namespace lars {
     
     template <class T> constexpr static bool NotDerivedFromAny = !std::is_base_of<Any,typename std::decay<T>::type>::value;
 
+    /**
+     * Allocates the payload of an Any holding a `T`, accounted if enabled.
+     */
+    template <class T, class VisitableType, typename ... Args> std::shared_ptr<VisitableType> makePayload(Args && ... args) {
+      if constexpr (anyAccountingEnabled) {
+        any_accounting_detail::Allocator<VisitableType> allocator(any_accounting_detail::getSlot<T>());
+        return std::allocate_shared<VisitableType>(allocator, std::forward<Args>(args)...);
+      } else {
+        return std::make_shared<VisitableType>(std::forward<Args>(args)...);
+      }
+    }
+
     template <class T> struct CapturedSharedPtr: public std::shared_ptr<T>{
       CapturedSharedPtr(const std::shared_ptr<T> &d):std::shared_ptr<T>(d){ }
       operator T & () { return **this; }
       operator const T & () const { return **this; }
     };
+
+    /**
+     * Exposes a visitable object only through its const interface.
+     */
+    class ConstVisitable final: public VisitableBase {
+    private:
+      std::shared_ptr<const VisitableBase> data;
+
+    public:
+      explicit ConstVisitable(std::shared_ptr<const VisitableBase> d):data(std::move(d)){ }
+
+      TypeIndex visitableType() const override { return data->visitableType(); }
+      void accept(VisitorBase &visitor) override { data->accept(visitor); }
+      void accept(VisitorBase &visitor) const override { data->accept(visitor); }
+      bool accept(RecursiveVisitorBase &visitor) override { return data->accept(visitor); }
+      bool accept(RecursiveVisitorBase &visitor) const override { return data->accept(visitor); }
+      const TypeSet & visitableTypeSet() const override { return data->visitableTypeSet(); }
+      const void * visitableAddress(size_t index) const override { return data->visitableAddress(index); }
+      TypeIndex storageType() const override { return getTypeIndex<ConstVisitable>(); }
+    };
   }
 
   /**
@@ -42,6 +78,8 @@ namespace lars {
    */
   class Any {
   protected:
+    friend class AtomicAny;
+    template <typename ... Pairs> friend class BiVisitor;
     std::shared_ptr<VisitableBase> data;
 
     Any(const Any &) = default;
@@ -82,7 +120,8 @@ namespace lars {
         data = value;
         return *value;
       } else {
-        auto value = std::make_shared<VisitableType>(std::forward<Args>(args)...);
+        auto value = any_detail::makePayload<T, VisitableType>(std::forward<Args>(args)...);
+        if constexpr (statisticsEnabled) { statistics_detail::recordAnyAllocation(); }
         data = value;
         return static_cast<typename VisitableType::Type &>(*value);
       }
@@ -101,6 +140,15 @@ namespace lars {
     void setReference(const Any & other){
       data = other.data;
     }
+
+    /**
+     * Captures the value from another any object as const. The value can be read, but not
+     * be modified or casted to a non-const reference through this object.
+     */
+    void setConstReference(const Any & other){
+      if (!other.data) { data.reset(); return; }
+      data = std::make_shared<any_detail::ConstVisitable>(other.data);
+    }
     
     /**
      * Casts the internal data to `T` using `visitor_cast`.
@@ -128,6 +176,39 @@ namespace lars {
       return visitor_cast<T*>(data.get());
     }
     
+    /**
+     * `true`, if the stored value can be casted to `const T &`. See `lars::isA`.
+     */
+    template <class T> bool holds() const {
+      return data && isA<T>(*data);
+    }
+
+    /**
+     * Returns a pointer to the stored value if it is of type `T`, stored as
+     * `AnyVisitable<T>::type` and not shared with other Any objects. `nullptr` will be
+     * returned otherwise, including for values captured through `std::reference_wrapper`
+     * or `std::shared_ptr`, which are owned elsewhere.
+     */
+    template <class T> T * tryGetUnique() {
+      if (!data || data.use_count() != 1 || type() != getStaticTypeIndex<T>()) { return nullptr; }
+      if (data->storageType() != getTypeIndex<typename AnyVisitable<T>::type>()) { return nullptr; }
+      return tryGet<T>();
+    }
+
+    /**
+     * Assigns `value` to the stored object if `tryGetUnique<T>()` succeeds, reusing the
+     * existing storage. Otherwise behaves like `Any::set<T>(value)`.
+     */
+    template <class T, typename V> void assign(V && value) {
+      if constexpr (std::is_assignable<T &, V &&>::value) {
+        if (auto stored = tryGetUnique<T>()) {
+          *stored = std::forward<V>(value);
+          return;
+        }
+      }
+      set<T>(std::forward<V>(value));
+    }
+
     /**
      * Returns a shared pointer containing the result of `Visitor.tryGet<T>()`.
      * Will return an empty `shared_ptr` if unsuccessful.
@@ -289,6 +370,17 @@ template <size_t N> struct lars::AnyVisitable<const char[N]> {
   using type = lars::AnyVisitable<std::string>::type;
 };
 
+/**
+ * String views can be converted to strings.
+ */
+template <> struct lars::AnyVisitable<std::string_view> {
+  using type = lars::DataVisitablePrototype<
+    std::string_view,
+    lars::TypeList<std::string_view &, const std::string_view &, std::string_view, std::string>,
+    lars::TypeList<const std::string_view &, std::string_view, std::string>
+  >;
+};
+
 /**
  * Capture values as reference through `std::reference_wrapper`.
  */
@@ -0,0 +1,283 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+#include <lars/type_index.h>
+
+namespace lars {
+
+  /**
+   * `true`, if the library is compiled with `LARS_ANY_ACCOUNTING` defined. Otherwise `Any`
+   * payloads are allocated without accounting and `getAnyAllocations` returns no entries.
+   */
+#ifdef LARS_ANY_ACCOUNTING
+  constexpr bool anyAccountingEnabled = true;
+#else
+  constexpr bool anyAccountingEnabled = false;
+#endif
+
+  /**
+   * The accounted `Any` payloads of a type.
+   */
+  struct AnyAllocationCounters {
+    TypeIndex type;
+    /**
+     * The number of payloads currently alive.
+     */
+    int64_t live = 0;
+    /**
+     * The bytes currently allocated for the payloads, including the reference count.
+     */
+    int64_t bytes = 0;
+    /**
+     * The total number of payloads allocated.
+     */
+    uint64_t allocations = 0;
+
+    explicit AnyAllocationCounters(TypeIndex t):type(t){ }
+  };
+
+  namespace any_accounting_detail {
+
+    using Counter = std::atomic<int64_t>;
+
+    /**
+     * Counters are only written by the thread owning the shard.
+     */
+    inline void add(Counter &counter, int64_t value) {
+      counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    struct Counters {
+      Counter live{0};
+      Counter bytes{0};
+      Counter allocations{0};
+    };
+
+    /**
+     * Assigns consecutive slots to accounted types.
+     */
+    class Types {
+    private:
+      std::mutex mutex;
+      std::vector<TypeIndex> types;
+
+    public:
+      size_t add(const TypeIndex &type) {
+        std::lock_guard<std::mutex> lock(mutex);
+        types.push_back(type);
+        return types.size() - 1;
+      }
+
+      std::vector<TypeIndex> get() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return types;
+      }
+    };
+
+    inline Types &getTypes() {
+      static Types types;
+      return types;
+    }
+
+    template <class T> size_t getSlot() {
+      static const size_t slot = getTypes().add(getTypeIndex<T>());
+      return slot;
+    }
+
+    /**
+     * The counters of a single thread, indexed by slot. Counters are stored in chunks so
+     * that they do not move when the shard grows. Frees are recorded by the releasing thread,
+     * so counters of a single shard may be negative.
+     */
+    class Shard {
+    private:
+      static constexpr size_t chunkSize = 64;
+      using Chunk = std::array<Counters, chunkSize>;
+
+      /**
+       * Guards growth of `chunks` against concurrent aggregation.
+       */
+      mutable std::mutex mutex;
+      std::vector<std::unique_ptr<Chunk>> chunks;
+
+    public:
+      Shard();
+      ~Shard();
+
+      Counters & get(size_t slot) {
+        auto chunk = slot / chunkSize;
+        if (chunk >= chunks.size()) {
+          std::lock_guard<std::mutex> lock(mutex);
+          while (chunks.size() <= chunk) { chunks.push_back(std::make_unique<Chunk>()); }
+        }
+        return (*chunks[chunk])[slot % chunkSize];
+      }
+
+      void addTo(std::vector<AnyAllocationCounters> &result) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (size_t slot = 0; slot < result.size() && slot / chunkSize < chunks.size(); ++slot) {
+          auto &counters = (*chunks[slot / chunkSize])[slot % chunkSize];
+          result[slot].live += counters.live.load(std::memory_order_relaxed);
+          result[slot].bytes += counters.bytes.load(std::memory_order_relaxed);
+          result[slot].allocations += uint64_t(counters.allocations.load(std::memory_order_relaxed));
+        }
+      }
+    };
+
+    /**
+     * All live shards and the merged counters of exited threads.
+     */
+    class Registry {
+    private:
+      std::mutex mutex;
+      std::vector<const Shard *> shards;
+      std::vector<AnyAllocationCounters> retired;
+
+      void resize(std::vector<AnyAllocationCounters> &counters, const std::vector<TypeIndex> &types) {
+        for (auto i = counters.size(); i < types.size(); ++i) { counters.emplace_back(types[i]); }
+      }
+
+    public:
+      void add(const Shard *shard) {
+        std::lock_guard<std::mutex> lock(mutex);
+        shards.push_back(shard);
+      }
+
+      void remove(const Shard *shard) {
+        auto types = getTypes().get();
+        std::lock_guard<std::mutex> lock(mutex);
+        resize(retired, types);
+        shard->addTo(retired);
+        shards.erase(std::find(shards.begin(), shards.end(), shard));
+      }
+
+      /**
+       * Records directly into the retired counters. Used for frees after the shard of the
+       * current thread has been destroyed.
+       */
+      void addRetired(size_t slot, int64_t live, int64_t bytes) {
+        auto types = getTypes().get();
+        std::lock_guard<std::mutex> lock(mutex);
+        resize(retired, types);
+        retired[slot].live += live;
+        retired[slot].bytes += bytes;
+      }
+
+      std::vector<AnyAllocationCounters> aggregate() {
+        auto types = getTypes().get();
+        std::lock_guard<std::mutex> lock(mutex);
+        auto result = retired;
+        resize(result, types);
+        for (auto shard: shards) { shard->addTo(result); }
+        return result;
+      }
+    };
+
+    inline Registry &getRegistry() {
+      static Registry registry;
+      return registry;
+    }
+
+    inline Shard::Shard() {
+      getRegistry().add(this);
+    }
+
+    inline Shard::~Shard() {
+      getRegistry().remove(this);
+    }
+
+    /**
+     * Set when the shard of the thread has been destroyed. Trivially destructible, so it
+     * remains valid while other thread-local or static objects release payloads.
+     */
+    inline thread_local bool shardDestroyed = false;
+
+    struct ShardOwner {
+      Shard * shard = nullptr;
+      ~ShardOwner() {
+        delete shard;
+        shard = nullptr;
+        shardDestroyed = true;
+      }
+    };
+
+    inline thread_local ShardOwner shardOwner;
+
+    inline void record(size_t slot, int64_t live, int64_t bytes) {
+      if (shardDestroyed) {
+        getRegistry().addRetired(slot, live, bytes);
+        return;
+      }
+      if (!shardOwner.shard) { shardOwner.shard = new Shard(); }
+      auto &counters = shardOwner.shard->get(slot);
+      add(counters.live, live);
+      add(counters.bytes, bytes);
+      if (live > 0) { add(counters.allocations, live); }
+    }
+
+    /**
+     * An allocator recording allocations in the slot of the accounted type.
+     */
+    template <class T> class Allocator {
+    private:
+      template <class U> friend class Allocator;
+      size_t slot;
+
+    public:
+      using value_type = T;
+
+      explicit Allocator(size_t s):slot(s){ }
+      template <class U> Allocator(const Allocator<U> &other):slot(other.slot){ }
+
+      T * allocate(size_t n) {
+        auto result = static_cast<T *>(::operator new(n * sizeof(T)));
+        record(slot, 1, int64_t(n * sizeof(T)));
+        return result;
+      }
+
+      void deallocate(T * p, size_t n) {
+        record(slot, -1, -int64_t(n * sizeof(T)));
+        ::operator delete(p);
+      }
+
+      template <class U> bool operator==(const Allocator<U> &other) const { return slot == other.slot; }
+      template <class U> bool operator!=(const Allocator<U> &other) const { return slot != other.slot; }
+    };
+
+  }
+
+  /**
+   * Returns the accounted `Any` payloads by type, aggregated over all threads and ordered by
+   * the bytes currently allocated, largest first. Counters of running threads are read
+   * without stopping them, so the result may miss concurrent allocations.
+   */
+  inline std::vector<AnyAllocationCounters> getAnyAllocations() {
+    if constexpr (anyAccountingEnabled) {
+      auto result = any_accounting_detail::getRegistry().aggregate();
+      std::stable_sort(result.begin(), result.end(), [](auto &a, auto &b){ return a.bytes > b.bytes; });
+      return result;
+    } else {
+      return std::vector<AnyAllocationCounters>();
+    }
+  }
+
+  /**
+   * Returns the accounted `Any` payloads of type `T`.
+   */
+  template <class T> AnyAllocationCounters getAnyAllocations() {
+    auto type = getStaticTypeIndex<T>();
+    for (auto &counters: getAnyAllocations()) {
+      if (counters.type == type) { return counters; }
+    }
+    return AnyAllocationCounters(getTypeIndex<T>());
+  }
+
+}
@@ -1,13 +1,24 @@
 #pragma once
 
 #include <lars/any.h>
+#include <lars/any_function_signature.h>
 #include <lars/make_function.h>
+#include <lars/thread_pool.h>
 
 #include <functional>
+#include <iterator>
 #include <memory>
 #include <exception>
 #include <array>
 #include <vector>
+#include <tuple>
+#include <mutex>
+#include <condition_variable>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#define LARS_ANY_FUTURE_COROUTINES
+#endif
 
 namespace lars {
   
@@ -19,6 +30,15 @@ namespace lars {
       return "use of undefined AnyFunction";
     }
   };
+
+  /**
+   * Is raised when the result of a default-constructed AnyFuture is accessed
+   */
+  struct UndefinedAnyFutureException:public std::exception{
+    const char * what() const noexcept override {
+      return "use of undefined AnyFuture";
+    }
+  };
   
   /**
    * Is raised when a any function is called with the wrong number of arguments
@@ -29,12 +49,264 @@ namespace lars {
     }
   };
 
+  /**
+   * Is raised when the argument columns of a batched call have different lengths
+   */
+  struct AnyFunctionInvalidColumnSizeException:public std::exception{
+    const char * what() const noexcept override {
+      return "called AnyFunction with argument columns of different lengths";
+    }
+  };
+
   class AnyArguments:public std::vector<AnyReference>{ 
     using std::vector<AnyReference>::vector; 
   };
+
+  namespace any_function_detail {
+    template <class T> struct AssignVisitor: public Visitor<T> {
+      T &target;
+      AssignVisitor(T &t):target(t){ }
+      void visit(T t) override { target = std::move(t); }
+    };
+
+    template <class T, class F> struct ArgumentVisitor: public Visitor<T> {
+      const F &f;
+      ArgumentVisitor(const F &_f):f(_f){ }
+      void visit(T t) override { f(std::forward<T>(t)); }
+    };
+
+    template <class Value, class Arg> struct IsDirectColumnType: public std::is_convertible<
+      typename std::vector<Value>::reference,
+      Arg
+    > { };
+
+    /**
+     * Converts a row of a `std::vector<Element>` column to `Value`.
+     */
+    template <class Value, class Element> Value convertRow(const void * values, size_t row) {
+      return static_cast<Value>((*static_cast<const std::vector<Element> *>(values))[row]);
+    }
+
+    /**
+     * Reads the rows of a column for a batched call. The column is an Any holding either a
+     * `std::vector` of the argument's value type or `AnyArguments`. Arithmetic arguments
+     * passed by value or const reference also accept vectors of the numeric types converted
+     * by `Any`. The conversion is resolved once per column and applied to every row.
+     */
+    template <class Arg> class BatchColumn {
+    private:
+      using Value = typename std::decay<Arg>::type;
+      static constexpr bool isDirect = std::conjunction<
+        std::negation<std::is_abstract<Value>>,
+        IsDirectColumnType<Value, Arg>
+      >::value;
+      static constexpr bool isConvertible = std::is_arithmetic<Value>::value && (
+        !std::is_reference<Arg>::value || std::is_const<typename std::remove_reference<Arg>::type>::value
+      );
+      using Values = typename std::conditional<isDirect, std::vector<Value>, AnyArguments>::type;
+      using Converter = Value (*)(const void *, size_t);
+
+      Values * values = nullptr;
+      AnyArguments * anyValues = nullptr;
+      const void * convertedValues = nullptr;
+      Converter convert = nullptr;
+      size_t convertedSize = 0;
+
+      template <typename ... Elements> bool resolveConversion(const Any & column, TypeList<Elements...>) {
+        auto tryElement = [&](auto * element){
+          using Element = typename std::remove_pointer<decltype(element)>::type;
+          auto elements = column.tryGet<std::vector<Element>>();
+          if (!elements) { return false; }
+          convertedValues = elements;
+          convert = &convertRow<Value, Element>;
+          convertedSize = elements->size();
+          return true;
+        };
+        return (tryElement(static_cast<Elements *>(nullptr)) || ...);
+      }
+
+    public:
+      /**
+       * The type of a row. Arithmetic rows are read by value, so converted rows need no storage.
+       */
+      using Row = typename std::conditional<isConvertible, Value, Arg>::type;
+
+      BatchColumn(const Any & column){
+        if constexpr (isDirect) { values = column.tryGet<Values>(); }
+        if constexpr (isConvertible) {
+          if (!values) { resolveConversion(column, LARS_ANY_NUMERIC_TYPES()); }
+        }
+        if (!values && !convert) { anyValues = column.tryGet<AnyArguments>(); }
+        if (!values && !convert && !anyValues) { 
+          throw InvalidVisitorException(column.type(), getTypeIndex<TypeList<Values &, AnyArguments &>>());
+        }
+      }
+
+      size_t size() const {
+        if (values) { return values->size(); }
+        return convert ? convertedSize : anyValues->size();
+      }
+
+      Row operator[](size_t row) const {
+        if constexpr (isDirect) {
+          if (values) { return (*values)[row]; }
+        }
+        if constexpr (isConvertible) {
+          if (convert) { return convert(convertedValues, row); }
+        }
+        return (*anyValues)[row].template get<Arg>();
+      }
+    };
+
+    inline size_t batchSize(std::initializer_list<size_t> columnSizes) {
+      if (columnSizes.size() == 0) { return 0; }
+      auto size = *columnSizes.begin();
+      for (auto columnSize: columnSizes) {
+        if (columnSize != size) { throw AnyFunctionInvalidColumnSizeException(); }
+      }
+      return size;
+    }
+
+    /**
+     * The number and size of the chunks `[0, rows)` is split into when processed by at most
+     * `chunks` threads.
+     */
+    struct Chunks {
+      size_t count;
+      size_t size;
+    };
+
+    inline Chunks splitRows(size_t rows, size_t chunks) {
+      if (chunks <= 1 || rows <= 1) { return Chunks{1, rows}; }
+      chunks = std::min(chunks, rows);
+      return Chunks{chunks, (rows + chunks - 1) / chunks};
+    }
+
+    /**
+     * Calls `f(begin, end)` for the chunks of `[0, rows)` given by `splitRows` on the shared
+     * thread pool.
+     */
+    template <class F> void forEachChunk(size_t rows, size_t chunks, const F &f) {
+      auto split = splitRows(rows, chunks);
+      if (split.count == 1) {
+        f(size_t(0), rows);
+        return;
+      }
+      ThreadPool::shared().forEach(split.count, [&](size_t i){
+        f(std::min(rows, i * split.size), std::min(rows, (i + 1) * split.size));
+      });
+    }
+  }
   
+  namespace any_function_detail {
+    /**
+     * Stores a copy of `value`, which holds a `Result`, in `copy`. Returns `false` for results
+     * without value semantics: `Any` objects, values shared through a `std::shared_ptr` and
+     * values that are not stored as `Result`, such as captured references.
+     */
+    template <class Result> bool copyResult(const Any & value, Any & copy) {
+      if constexpr (
+        std::is_same<void, Result>::value
+        || std::is_base_of<Any, Result>::value
+        || any_detail::is_shared_ptr<Result>::value
+        || !std::is_copy_constructible<Result>::value
+      ) {
+        (void)value;
+        (void)copy;
+        return false;
+      } else {
+        auto stored = value.tryGet<const Result>();
+        if (!stored) { return false; }
+        copy.assign<Result>(*stored);
+        return true;
+      }
+    }
+  }
+
   struct SpecificAnyFunctionBase {
     virtual Any call(const AnyArguments & args) const = 0;
+
+    /**
+     * Stores an independent copy of `value`, a result returned by this function, in `copy`,
+     * reusing its storage if possible. Returns `false` if the results cannot be copied.
+     */
+    virtual bool copyResult(const Any & value, Any & copy) const {
+      (void)value;
+      (void)copy;
+      return false;
+    }
+
+    /**
+     * Calls the function and stores the result in `result`.
+     * Implementations may reuse the storage of `result`.
+     */
+    virtual void callInto(const AnyArguments & args, Any & result) const {
+      result = call(args);
+    }
+
+    /**
+     * Calls the function and accepts the visitor with the result.
+     * Implementations may store the result in a temporary visitable instead of an `Any`.
+     */
+    virtual void callAndVisit(const AnyArguments & args, VisitorBase & visitor) const {
+      call(args).accept(visitor);
+    }
+
+    /**
+     * Is called with a visitor that receives the argument of a visitable argument call.
+     */
+    using ArgumentProducer = std::function<void(VisitorBase &)>;
+
+    /**
+     * `true`, if the function takes a single argument and implements `callVisitedInto` and
+     * `callVisitedAndVisit`.
+     */
+    virtual bool acceptsVisitableArgument() const {
+      return false;
+    }
+
+    /**
+     * Calls the function with the argument received by the visitor passed to `produceArgument`
+     * and stores the result in `result`. This allows passing arguments without an `Any`.
+     */
+    virtual void callVisitedInto(const ArgumentProducer & produceArgument, Any & result) const {
+      (void)produceArgument;
+      (void)result;
+      throw AnyFunctionInvalidArgumentCountException();
+    }
+
+    /**
+     * Same as `callVisitedInto`, but accepts `visitor` with the result.
+     */
+    virtual void callVisitedAndVisit(const ArgumentProducer & produceArgument, VisitorBase & visitor) const {
+      (void)produceArgument;
+      (void)visitor;
+      throw AnyFunctionInvalidArgumentCountException();
+    }
+
+    /**
+     * Calls the function for every row of the argument columns. See `AnyFunction::callBatch`.
+     * The default implementation accepts `AnyArguments` columns only and calls `call` for every row.
+     */
+    virtual void callBatch(const AnyArguments & columns, Any & result, size_t threads) const {
+      std::vector<any_function_detail::BatchColumn<const Any &>> readers(columns.begin(), columns.end());
+      auto rows = columns.size() > 0 ? readers[0].size() : 0;
+      for (auto & reader: readers) {
+        if (reader.size() != rows) { throw AnyFunctionInvalidColumnSizeException(); }
+      }
+      auto values = result.tryGetUnique<AnyArguments>();
+      if (!values) { values = &result.set<AnyArguments>(); }
+      values->resize(rows);
+      any_function_detail::forEachChunk(rows, threads, [&](size_t begin, size_t end){
+        AnyArguments args(readers.size());
+        for (auto row = begin; row < end; ++row) {
+          for (size_t i = 0; i < readers.size(); ++i) { args[i] = readers[i][row]; }
+          (*values)[row] = call(args);
+        }
+      });
+    }
+
+    virtual const AnyFunctionSignature & signature()const = 0;
     virtual TypeIndex returnType()const = 0;
     virtual TypeIndex argumentType(size_t)const = 0;
     virtual size_t argumentCount()const = 0;
@@ -47,13 +319,79 @@ namespace lars {
   template <class R, typename ... Args> class SpecificAnyFunction<R, Args...>: public SpecificAnyFunctionBase {
   private:
     std::function<R(Args...)> callback;
+
+    static constexpr std::array<TypeIndex, sizeof...(Args)> argumentTypeIndices{
+      getTypeIndex<typename std::decay<Args>::type>()...
+    };
+
+    static constexpr std::array<StaticTypeIndex, sizeof...(Args)> staticArgumentTypeIndices{
+      getStaticTypeIndex<typename std::decay<Args>::type>()...
+    };
   
-    template <size_t ... Idx> Any callWithArgumentIndices(const AnyArguments & args, std::index_sequence<Idx...>) const {
+    using Indices = std::make_index_sequence<sizeof...(Args)>;
+    using Result = typename any_detail::remove_cvref<R>::type;
+
+    /**
+     * `true`, if the result can be held by a temporary visitable instead of an `Any`.
+     */
+    static constexpr bool isDirectlyVisitable = !std::is_base_of<Any, Result>::value
+      && !std::is_base_of<VisitableBase, typename any_detail::is_shared_ptr<Result>::value_type>::value;
+
+    template <size_t ... Idx> R callWithArgumentIndices(const AnyArguments & args, std::index_sequence<Idx...>) const {
+      return callback(args[Idx].get<Args>()...);
+    }
+
+    void checkArgumentCount(const AnyArguments & args) const {
+      if (args.size() != sizeof...(Args)){ throw AnyFunctionInvalidArgumentCountException(); }
+    }
+
+    /**
+     * Results of batched calls are stored as `std::vector<Result>` if possible.
+     */
+    using BatchResult = typename std::conditional<
+      std::is_copy_constructible<Result>::value && !std::is_base_of<Any, Result>::value,
+      std::vector<Result>,
+      AnyArguments
+    >::type;
+
+    template <size_t ... Idx> void callBatchWithArgumentIndices(
+      const AnyArguments & columns, 
+      Any & result, 
+      size_t threads, 
+      std::index_sequence<Idx...>
+    ) const {
+      std::tuple<any_function_detail::BatchColumn<Args>...> readers{ columns[Idx]... };
+      auto rows = any_function_detail::batchSize({ std::get<Idx>(readers).size()... });
+      (void)readers; // silence unused variable warning for functions without arguments
+
       if constexpr (std::is_same<void, R>::value) {
-        callback(args[Idx].get<Args>()...);
-        return Any();
+        any_function_detail::forEachChunk(rows, threads, [&](size_t begin, size_t end){
+          for (auto row = begin; row < end; ++row) { callback(std::get<Idx>(readers)[row]...); }
+        });
+        result.reset();
       } else {
-        return callback(args[Idx].get<Args>()...);
+        auto values = result.tryGetUnique<BatchResult>();
+        if (!values) { values = &result.set<BatchResult>(); }
+        using Value = typename BatchResult::value_type;
+        if constexpr (std::is_default_constructible<Value>::value && !std::is_same<bool, Value>::value) {
+          values->resize(rows);
+          any_function_detail::forEachChunk(rows, threads, [&](size_t begin, size_t end){
+            for (auto row = begin; row < end; ++row) { (*values)[row] = Value(callback(std::get<Idx>(readers)[row]...)); }
+          });
+        } else {
+          // values cannot be assigned to preallocated rows, so chunks are collected separately
+          auto split = any_function_detail::splitRows(rows, threads);
+          std::vector<BatchResult> chunks(split.count - 1);
+          values->clear();
+          any_function_detail::forEachChunk(rows, threads, [&](size_t begin, size_t end){
+            if (begin == end) { return; }
+            auto &chunk = begin == 0 ? *values : chunks[begin / split.size - 1];
+            chunk.reserve(end - begin);
+            for (auto row = begin; row < end; ++row) { chunk.emplace_back(callback(std::get<Idx>(readers)[row]...)); }
+          });
+          values->reserve(rows);
+          for (auto &chunk: chunks) { values->insert(values->end(), std::make_move_iterator(chunk.begin()), std::make_move_iterator(chunk.end())); }
+        }
       }
     }
 
@@ -62,9 +400,100 @@ namespace lars {
     SpecificAnyFunction(std::function<R(Args...)> _callback):callback(_callback){}
     
     Any call(const AnyArguments & args) const override {
-      if (args.size() != sizeof...(Args)){ throw AnyFunctionInvalidArgumentCountException(); }
-      using Indices = std::make_index_sequence<sizeof...(Args)>;
-      return callWithArgumentIndices(args, Indices());
+      checkArgumentCount(args);
+      if constexpr (std::is_same<void, R>::value) {
+        callWithArgumentIndices(args, Indices());
+        return Any();
+      } else {
+        return callWithArgumentIndices(args, Indices());
+      }
+    }
+
+    template <class F> void assignResult(Any & result, const F & invoke) const {
+      if constexpr (std::is_same<void, R>::value) {
+        invoke();
+        result.reset();
+      } else if constexpr (std::is_base_of<Any, Result>::value) {
+        result = invoke();
+      } else {
+        result.assign<Result>(invoke());
+      }
+    }
+
+    template <class F> void visitResult(VisitorBase & visitor, const F & invoke) const {
+      if constexpr (std::is_same<void, R>::value) {
+        invoke();
+        Any().accept(visitor);
+      } else if constexpr (!isDirectlyVisitable) {
+        Any(invoke()).accept(visitor);
+      } else {
+        typename AnyVisitable<Result>::type result(invoke());
+        result.accept(visitor);
+      }
+    }
+
+    template <class F> void visitArgument(const ArgumentProducer & produceArgument, const F & handle) const {
+      if constexpr (sizeof...(Args) == 1) {
+        any_function_detail::ArgumentVisitor<Args..., F> visitor(handle);
+        produceArgument(visitor);
+      } else {
+        (void)produceArgument;
+        (void)handle;
+        throw AnyFunctionInvalidArgumentCountException();
+      }
+    }
+
+    void callInto(const AnyArguments & args, Any & result) const override {
+      checkArgumentCount(args);
+      assignResult(result, [&]() -> R { return callWithArgumentIndices(args, Indices()); });
+    }
+
+    bool copyResult(const Any & value, Any & copy) const override {
+      return any_function_detail::copyResult<Result>(value, copy);
+    }
+
+    void callAndVisit(const AnyArguments & args, VisitorBase & visitor) const override {
+      checkArgumentCount(args);
+      visitResult(visitor, [&]() -> R { return callWithArgumentIndices(args, Indices()); });
+    }
+
+    /**
+     * Arguments taken as `Any` or `std::shared_ptr` are special cased by `Any::get` and cannot
+     * be received by a visitor, so they require an `Any` argument.
+     */
+    bool acceptsVisitableArgument() const override {
+      return sizeof...(Args) == 1 && (... && (
+        !std::is_base_of<Any, typename any_detail::remove_cvref<Args>::type>::value
+        && !any_detail::is_shared_ptr<typename any_detail::remove_cvref<Args>::type>::value
+      ));
+    }
+
+    void callVisitedInto(const ArgumentProducer & produceArgument, Any & result) const override {
+      visitArgument(produceArgument, [&](Args ... arg){
+        assignResult(result, [&]() -> R { return callback(std::forward<Args>(arg)...); });
+      });
+    }
+
+    void callVisitedAndVisit(const ArgumentProducer & produceArgument, VisitorBase & visitor) const override {
+      visitArgument(produceArgument, [&](Args ... arg){
+        visitResult(visitor, [&]() -> R { return callback(std::forward<Args>(arg)...); });
+      });
+    }
+
+    void callBatch(const AnyArguments & columns, Any & result, size_t threads) const override {
+      checkArgumentCount(columns);
+      callBatchWithArgumentIndices(columns, result, threads, Indices());
+    }
+
+    static constexpr AnyFunctionSignature staticSignature{
+      getStaticTypeIndex<R>(),
+      staticArgumentTypeIndices.data(),
+      sizeof...(Args),
+      false
+    };
+
+    const AnyFunctionSignature & signature()const override{
+      return staticSignature;
     }
 
     TypeIndex returnType()const override{
@@ -79,10 +508,7 @@ namespace lars {
       if (i >= sizeof...(Args)) {
         return getTypeIndex<void>();
       } else {
-        std::array<TypeIndex,sizeof...(Args)> argumentTypes{
-          getTypeIndex<typename std::decay<Args>::type>()...
-        };
-        return argumentTypes[i];
+        return argumentTypeIndices[i];
       }
     }
 
@@ -106,6 +532,21 @@ namespace lars {
         return callback(args);
       }
     }
+
+    bool copyResult(const Any & value, Any & copy) const override {
+      return any_function_detail::copyResult<typename any_detail::remove_cvref<R>::type>(value, copy);
+    }
+
+    static constexpr AnyFunctionSignature staticSignature{
+      getStaticTypeIndex<R>(),
+      nullptr,
+      0,
+      true
+    };
+
+    const AnyFunctionSignature & signature()const override{
+      return staticSignature;
+    }
     
     TypeIndex returnType()const override{
       return getTypeIndex<R>();
@@ -125,12 +566,150 @@ namespace lars {
 
   };
   
+  /**
+   * The result of an asynchronous call to an any function.
+   * Copies of an AnyFuture refer to the same result.
+   */
+  class AnyFuture {
+  private:
+    struct State {
+      std::mutex mutex;
+      std::condition_variable condition;
+      bool ready = false;
+      Any value;
+      std::exception_ptr error;
+      std::vector<std::function<void()>> continuations;
+    };
+
+    std::shared_ptr<State> state;
+
+    State & getState() const {
+      if (!state) { throw UndefinedAnyFutureException(); }
+      return *state;
+    }
+
+    void complete(std::function<void(State &)> setResult) const {
+      auto & s = getState();
+      std::vector<std::function<void()>> continuations;
+      {
+        std::lock_guard<std::mutex> lock(s.mutex);
+        setResult(s);
+        s.ready = true;
+        continuations = std::move(s.continuations);
+      }
+      s.condition.notify_all();
+      for (auto & continuation: continuations) { continuation(); }
+    }
+
+    /**
+     * Adds `f` to the continuations if the result is not yet available.
+     * Returns `false` otherwise.
+     */
+    bool addContinuation(std::function<void()> && f) const {
+      auto & s = getState();
+      std::lock_guard<std::mutex> lock(s.mutex);
+      if (s.ready) { return false; }
+      s.continuations.emplace_back(std::move(f));
+      return true;
+    }
+
+  public:
+    AnyFuture(){ }
+
+    /**
+     * Creates a future that can be completed using `setValue` or `setException`.
+     */
+    static AnyFuture create() {
+      AnyFuture future;
+      future.state = std::make_shared<State>();
+      return future;
+    }
+
+    void setValue(Any && value) const {
+      complete([&](State &s){ s.value = std::move(value); });
+    }
+
+    void setException(std::exception_ptr error) const {
+      complete([&](State &s){ s.error = error; });
+    }
+
+    /**
+     * `true`, if the future refers to a result.
+     */
+    bool valid() const {
+      return bool(state);
+    }
+
+    /**
+     * `true`, if the result is available.
+     * Raises an `UndefinedAnyFutureException` if the future is not valid.
+     */
+    bool isReady() const {
+      auto & s = getState();
+      std::lock_guard<std::mutex> lock(s.mutex);
+      return s.ready;
+    }
+
+    /**
+     * Blocks until the result is available. When called from a worker of a thread pool,
+     * queued tasks of that pool are run while waiting.
+     * Raises an `UndefinedAnyFutureException` if the future is not valid.
+     */
+    void wait() const {
+      auto & s = getState();
+      auto pool = ThreadPool::current();
+      std::unique_lock<std::mutex> lock(s.mutex);
+      if (pool) {
+        pool->helpUntil(lock, s.condition, [&](){ return s.ready; });
+      } else {
+        s.condition.wait(lock, [&](){ return s.ready; });
+      }
+    }
+
+    /**
+     * Waits for the result and returns it. Exceptions raised by the call are rethrown.
+     */
+    Any get() const {
+      wait();
+      if (state->error) { std::rethrow_exception(state->error); }
+      return AnyReference(state->value);
+    }
+
+    /**
+     * Calls `f` once the result is available. If the result is already available, `f` is
+     * called immediately. Otherwise it is called from the thread completing the future,
+     * after the continuations added before.
+     */
+    void then(std::function<void()> f) const {
+      if (!addContinuation(std::move(f))) { f(); }
+    }
+
+#ifdef LARS_ANY_FUTURE_COROUTINES
+    /**
+     * Allows awaiting the result in C++20 coroutines.
+     * The coroutine is resumed in the thread completing the future.
+     */
+    auto operator co_await() const {
+      struct Awaiter {
+        AnyFuture future;
+        bool await_ready() const { return future.isReady(); }
+        bool await_suspend(std::coroutine_handle<> handle) const {
+          return future.addContinuation([handle](){ handle.resume(); });
+        }
+        Any await_resume() const { return future.get(); }
+      };
+      return Awaiter{*this};
+    }
+#endif
+
+  };
+
   /**
    * Holds a functions of Any type.
    */
   class AnyFunction{
   private:
-    std::shared_ptr<SpecificAnyFunctionBase> specific;
+    std::shared_ptr<const SpecificAnyFunctionBase> specific;
     
     template <class R,typename ... Args> void _set(const std::function<R(Args...)> &f){
       specific = std::make_shared<SpecificAnyFunction<R,Args...>>(f);
@@ -161,11 +740,96 @@ namespace lars {
       static_assert(!std::is_convertible<F, AnyFunction>::value);
       _set(make_function(f));
     }
+
+    /**
+     * Creates an AnyFunction from a custom `SpecificAnyFunctionBase` implementation.
+     */
+    static AnyFunction fromSpecific(std::shared_ptr<const SpecificAnyFunctionBase> specific){
+      AnyFunction f;
+      f.specific = std::move(specific);
+      return f;
+    }
+
+    /**
+     * The implementation of the function. `nullptr`, if undefined.
+     */
+    const std::shared_ptr<const SpecificAnyFunctionBase> & getSpecific() const {
+      return specific;
+    }
     
     Any call(const AnyArguments & args) const {
       if (!specific) { throw UndefinedAnyFunctionException(); }
+      if constexpr (statisticsEnabled) { statistics_detail::recordAnyFunctionCall(); }
+      tracing_detail::CallSpan<tracingEnabled> span(*specific);
       return specific->call(args);
     }
+
+    /**
+     * Calls the function and stores the result in `result`. If `result` holds a value of
+     * the return type that is not shared with other Any objects, it will be assigned in-place
+     * instead of allocating new storage.
+     */
+    void call(const AnyArguments & args, Any & result) const {
+      if (!specific) { throw UndefinedAnyFunctionException(); }
+      if constexpr (statisticsEnabled) { statistics_detail::recordAnyFunctionCall(); }
+      tracing_detail::CallSpan<tracingEnabled> span(*specific);
+      specific->callInto(args, result);
+    }
+
+    /**
+     * Calls the function and assigns the result, casted to `T`, to `result`.
+     * The conversion rules are the same as for `Any::get<T>()`, however no intermediate `Any`
+     * is created for the result.
+     */
+    template <
+      class T,
+      typename = typename std::enable_if<any_detail::NotDerivedFromAny<T>>::type
+    > void call(const AnyArguments & args, T & result) const {
+      if (!specific) { throw UndefinedAnyFunctionException(); }
+      if constexpr (statisticsEnabled) { statistics_detail::recordAnyFunctionCall(); }
+      tracing_detail::CallSpan<tracingEnabled> span(*specific);
+      any_function_detail::AssignVisitor<T> visitor(result);
+      specific->callAndVisit(args, visitor);
+    }
+    
+    /**
+     * Calls the function once for every row of the argument columns and stores the results in
+     * `result`. Every column is an Any holding either a `std::vector` of the argument's value
+     * type or `AnyArguments`. Arithmetic arguments also accept vectors of other numeric types.
+     * Column types and conversions are resolved once per batch, so typed columns are read
+     * without any per-row casts.
+     * The results are stored as a `std::vector` of the return type, or as `AnyArguments` if
+     * the return type is not copyable. Existing storage in `result` will be reused if possible.
+     * If `threads` is larger than one, the rows are split into chunks that are processed in parallel.
+     */
+    void callBatch(const AnyArguments & columns, Any & result, size_t threads = 1) const {
+      if (!specific) { throw UndefinedAnyFunctionException(); }
+      if constexpr (statisticsEnabled) { statistics_detail::recordAnyFunctionCall(); }
+      tracing_detail::CallSpan<tracingEnabled> span(*specific);
+      specific->callBatch(columns, result, threads);
+    }
+    
+    /**
+     * Calls the function asynchronously on `pool`. The arguments are moved into the task,
+     * values captured by reference must remain valid until the call has finished.
+     */
+    AnyFuture callAsync(AnyArguments && args, ThreadPool & pool = ThreadPool::shared()) const {
+      if (!specific) { throw UndefinedAnyFunctionException(); }
+      if constexpr (statisticsEnabled) { statistics_detail::recordAnyFunctionCall(); }
+      auto future = AnyFuture::create();
+      pool.push([future, function = specific, args = std::move(args)](){
+        try {
+          // the span is closed before the future becomes ready
+          future.setValue([&](){
+            tracing_detail::CallSpan<tracingEnabled> span(*function);
+            return function->call(args);
+          }());
+        } catch (...) {
+          future.setException(std::current_exception());
+        }
+      });
+      return future;
+    }
     
     template <typename ... Args> Any operator()(Args && ... args) const {
       AnyArguments arguments{{[&](){
@@ -185,6 +849,14 @@ namespace lars {
       return bool(specific);
     }
     
+    /**
+     * Returns the static signature descriptor of the function.
+     */
+    const AnyFunctionSignature & signature()const{
+      if (!specific) { throw UndefinedAnyFunctionException(); }
+      return specific->signature();
+    }
+
     TypeIndex returnType()const{
       if (!specific) { throw UndefinedAnyFunctionException(); }
       return specific->returnType();
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <lars/any_function.h>
+
+#include <array>
+#include <utility>
+#include <vector>
+
+namespace lars {
+
+  namespace any_function_composition_detail {
+
+    /**
+     * Argument vectors kept by a thread for reuse. `destroyed` is trivially destructible, so
+     * it remains valid while other thread-local objects are destroyed.
+     */
+    struct ArgumentPool {
+      static constexpr size_t maxSize = 16;
+      std::vector<AnyArguments> buffers;
+      static thread_local bool destroyed;
+      ~ArgumentPool() { destroyed = true; }
+    };
+
+    inline thread_local bool ArgumentPool::destroyed = false;
+
+    inline ArgumentPool * getArgumentPool() {
+      static thread_local ArgumentPool pool;
+      return ArgumentPool::destroyed ? nullptr : &pool;
+    }
+
+    /**
+     * An argument vector taken from the pool of the calling thread and returned on
+     * destruction, so that its capacity is reused by later calls. Nested calls take separate
+     * vectors.
+     */
+    class ArgumentBuffer {
+    private:
+      AnyArguments buffer;
+
+    public:
+      ArgumentBuffer() {
+        auto pool = getArgumentPool();
+        if (pool && !pool->buffers.empty()) {
+          buffer = std::move(pool->buffers.back());
+          pool->buffers.pop_back();
+        }
+      }
+
+      ArgumentBuffer(const ArgumentBuffer &) = delete;
+      ArgumentBuffer &operator=(const ArgumentBuffer &) = delete;
+
+      ~ArgumentBuffer() {
+        buffer.clear();
+        auto pool = getArgumentPool();
+        if (pool && pool->buffers.size() < ArgumentPool::maxSize) { pool->buffers.push_back(std::move(buffer)); }
+      }
+
+      AnyArguments & get() {
+        return buffer;
+      }
+    };
+
+  }
+
+  /**
+   * An any function with its leading arguments bound to fixed values.
+   * The combined arguments are assembled in a reused per-thread buffer, so calls do not
+   * allocate an argument vector.
+   */
+  template <size_t N> class BoundAnyFunction: public SpecificAnyFunctionBase {
+  private:
+    std::shared_ptr<const SpecificAnyFunctionBase> function;
+    std::array<AnyReference, N> bound;
+    AnyFunctionSignature boundSignature;
+
+    /**
+     * Calls `f` with the bound arguments followed by `args`.
+     */
+    template <class F> decltype(auto) withArguments(const AnyArguments & args, const F & f) const {
+      any_function_composition_detail::ArgumentBuffer buffer;
+      auto & arguments = buffer.get();
+      arguments.reserve(N + args.size());
+      arguments.insert(arguments.end(), bound.begin(), bound.end());
+      arguments.insert(arguments.end(), args.begin(), args.end());
+      return f(std::as_const(arguments));
+    }
+
+  public:
+    BoundAnyFunction(const AnyFunction & f, std::array<AnyReference, N> && b):function(f.getSpecific()),bound(std::move(b)),boundSignature(f.signature()){
+      if (!boundSignature.isVariadic) {
+        if (boundSignature.argumentCount < N) { throw AnyFunctionInvalidArgumentCountException(); }
+        boundSignature.argumentTypes += N;
+        boundSignature.argumentCount -= N;
+      }
+    }
+
+    Any call(const AnyArguments & args) const override {
+      return withArguments(args, [&](const AnyArguments & arguments){ return function->call(arguments); });
+    }
+
+    void callInto(const AnyArguments & args, Any & result) const override {
+      withArguments(args, [&](const AnyArguments & arguments){ function->callInto(arguments, result); });
+    }
+
+    void callAndVisit(const AnyArguments & args, VisitorBase & visitor) const override {
+      withArguments(args, [&](const AnyArguments & arguments){ function->callAndVisit(arguments, visitor); });
+    }
+
+    bool copyResult(const Any & value, Any & copy) const override {
+      return function->copyResult(value, copy);
+    }
+
+    const AnyFunctionSignature & signature()const override{
+      return boundSignature;
+    }
+
+    TypeIndex returnType()const override{
+      return function->returnType();
+    }
+
+    TypeIndex argumentType(size_t i)const override{
+      return function->argumentType(function->isVariadic() ? i : i + N);
+    }
+
+    size_t argumentCount()const override{
+      return boundSignature.argumentCount;
+    }
+
+    bool isVariadic()const override{
+      return boundSignature.isVariadic;
+    }
+  };
+
+  /**
+   * A sequence of any functions, where the result of each function is passed to the next.
+   * If all functions after the first implement `callVisitedInto`, the intermediate results are
+   * passed as temporary visitables instead of being stored in `Any` objects.
+   */
+  class ComposedAnyFunction: public SpecificAnyFunctionBase {
+  private:
+    std::vector<std::shared_ptr<const SpecificAnyFunctionBase>> stages;
+    AnyFunctionSignature composedSignature;
+    bool fused;
+
+    /**
+     * Accepts a visitor with the result of the stage `stage`.
+     */
+    struct Producer {
+      const ComposedAnyFunction * self;
+      const AnyArguments * args;
+      size_t stage;
+
+      void operator()(VisitorBase & visitor) const {
+        if (stage == 0) {
+          self->stages[0]->callAndVisit(*args, visitor);
+        } else {
+          Producer previous{self, args, stage - 1};
+          self->stages[stage]->callVisitedAndVisit(std::cref(previous), visitor);
+        }
+      }
+    };
+
+  public:
+    ComposedAnyFunction(const std::vector<AnyFunction> & functions):composedSignature(functions.at(0).signature()),fused(true){
+      for (size_t i = 0; i < functions.size(); ++i) {
+        auto & specific = functions[i].getSpecific();
+        if (!specific) { throw UndefinedAnyFunctionException(); }
+        if (i > 0) {
+          if (!specific->isVariadic() && specific->argumentCount() != 1) {
+            throw AnyFunctionInvalidArgumentCountException();
+          }
+          fused &= specific->acceptsVisitableArgument();
+        }
+        stages.push_back(specific);
+      }
+      composedSignature.returnType = stages.back()->signature().returnType;
+    }
+
+    Any call(const AnyArguments & args) const override {
+      Any result;
+      callInto(args, result);
+      return result;
+    }
+
+    void callInto(const AnyArguments & args, Any & result) const override {
+      auto last = stages.size() - 1;
+      if (last == 0) {
+        stages[0]->callInto(args, result);
+      } else if (fused) {
+        Producer previous{this, &args, last - 1};
+        stages[last]->callVisitedInto(std::cref(previous), result);
+      } else {
+        Any value;
+        stages[0]->callInto(args, value);
+        for (size_t i = 1; i <= last; ++i) {
+          Any next;
+          stages[i]->callInto(AnyArguments{value}, i == last ? result : next);
+          value = std::move(next);
+        }
+      }
+    }
+
+    void callAndVisit(const AnyArguments & args, VisitorBase & visitor) const override {
+      if (fused) {
+        Producer{this, &args, stages.size() - 1}(visitor);
+      } else {
+        call(args).accept(visitor);
+      }
+    }
+
+    bool copyResult(const Any & value, Any & copy) const override {
+      return stages.back()->copyResult(value, copy);
+    }
+
+    const AnyFunctionSignature & signature()const override{
+      return composedSignature;
+    }
+
+    TypeIndex returnType()const override{
+      return stages.back()->returnType();
+    }
+
+    TypeIndex argumentType(size_t i)const override{
+      return stages.front()->argumentType(i);
+    }
+
+    size_t argumentCount()const override{
+      return stages.front()->argumentCount();
+    }
+
+    bool isVariadic()const override{
+      return stages.front()->isVariadic();
+    }
+
+    /**
+     * `true`, if intermediate results are passed without creating `Any` objects.
+     */
+    bool isFused() const {
+      return fused;
+    }
+  };
+
+  /**
+   * Returns an AnyFunction that calls `f` with the `bound` values prepended to its arguments.
+   * The bound values are copied, unless they are Any objects, in which case they are captured.
+   */
+  template <typename ... Bound> AnyFunction bind(const AnyFunction & f, Bound && ... bound){
+    if (!f) { throw UndefinedAnyFunctionException(); }
+    std::array<AnyReference, sizeof...(Bound)> values{ AnyReference(std::forward<Bound>(bound))... };
+    return AnyFunction::fromSpecific(std::make_shared<BoundAnyFunction<sizeof...(Bound)>>(f, std::move(values)));
+  }
+
+  /**
+   * Returns an AnyFunction that calls the functions in sequence, passing the result of each
+   * function as the argument of the next. `compose(f, g)(x)` is equivalent to `g(f(x))`.
+   */
+  template <typename ... Functions> AnyFunction compose(const AnyFunction & first, const Functions & ... functions){
+    return AnyFunction::fromSpecific(std::make_shared<ComposedAnyFunction>(std::vector<AnyFunction>{first, AnyFunction(functions)...}));
+  }
+
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstddef>
+
+#include <lars/type_index.h>
+
+namespace lars {
+
+  /**
+   * Describes the signature of an any function.
+   * A single static instance exists for every `SpecificAnyFunction` type, so introspection
+   * does not allocate. The argument types can be iterated using `begin()` and `end()`.
+   * They are stored as a pointer and a count, as `std::span` requires C++20.
+   */
+  struct AnyFunctionSignature {
+    StaticTypeIndex returnType;
+    const StaticTypeIndex * argumentTypes;
+    size_t argumentCount;
+    bool isVariadic;
+
+    constexpr const StaticTypeIndex * begin() const { return argumentTypes; }
+    constexpr const StaticTypeIndex * end() const { return argumentTypes + argumentCount; }
+  };
+
+}
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <lars/any.h>
+#include <lars/type_map.h>
+
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace lars {
+
+  /**
+   * Is raised when a value cannot be serialized or a buffer cannot be deserialized
+   */
+  class AnySerializationException: public std::exception {
+  private:
+    std::string buffer;
+
+  public:
+    AnySerializationException(std::string message):buffer(std::move(message)){ }
+
+    const char * what() const noexcept override {
+      return buffer.c_str();
+    }
+  };
+
+  namespace any_serializer_detail {
+
+    /**
+     * Entries and their payloads start at multiples of `alignment` relative to the buffer.
+     */
+    constexpr size_t alignment = 8;
+    constexpr char magic[4] = {'L', 'A', 'N', 'Y'};
+    constexpr uint32_t version = 1;
+    constexpr size_t headerSize = 16;
+    constexpr size_t entryHeaderSize = 16;
+
+    /**
+     * The type stored for empty Any objects.
+     */
+    constexpr uint64_t emptyType = 0;
+
+    inline size_t padding(size_t size) {
+      return (alignment - size % alignment) % alignment;
+    }
+
+    template <class T> void append(std::string &out, const T &value) {
+      out.append(reinterpret_cast<const char *>(&value), sizeof(T));
+    }
+
+    template <class T> T read(std::string_view buffer, size_t offset) {
+      T value;
+      std::memcpy(&value, buffer.data() + offset, sizeof(T));
+      return value;
+    }
+
+    inline void checkSize(std::string_view buffer, size_t offset, size_t size) {
+      if (offset > buffer.size() || buffer.size() - offset < size) {
+        throw AnySerializationException("truncated buffer");
+      }
+    }
+
+  }
+
+  /**
+   * Serializes Any objects to a compact binary format using per-type encoders.
+   *
+   * A buffer consists of a 16 byte header (`LANY`, the format version and the number of values)
+   * followed by an entry per value. Each entry stores the hash of the encoded type, the size of
+   * the payload and the payload, padded to a multiple of 8 bytes. Values are stored in the
+   * native byte order and types are identified by their `StaticTypeIndex`, so buffers can only
+   * be exchanged between processes built with the same compiler on the same host.
+   *
+   * Decoders receive a view of their payload and may return values referencing it. The
+   * built-in decoders return numeric values as `std::reference_wrapper<const T>`, so they are
+   * read without copying the payload. The buffer, for example a memory mapped file, must then
+   * outlive the decoded values. Values that are not suitably aligned in the buffer are copied
+   * instead. Strings are copied to a `std::string` unless `setStringViews` is enabled.
+   *
+   * Registration is not synchronized: all types should be added before the serializer is used
+   * concurrently.
+   */
+  class AnySerializer {
+  public:
+    using Encoder = std::function<void(const Any &value, std::string &out)>;
+    using Decoder = std::function<Any(std::string_view payload)>;
+
+  private:
+    struct EncoderEntry {
+      uint64_t type;
+      Encoder encode;
+    };
+
+    TypeMap<EncoderEntry> encoders;
+    std::unordered_map<uint64_t, Decoder> decoders;
+
+    template <typename ... T> void addTrivial(TypeList<T...>) {
+      (addTrivial<T>(), ...);
+    }
+
+  public:
+
+    /**
+     * Creates a serializer supporting the `LARS_ANY_NUMERIC_TYPES` and `std::string`.
+     */
+    AnySerializer() {
+      addTrivial(LARS_ANY_NUMERIC_TYPES());
+      setStringViews(false);
+      addAlias<std::string_view, std::string>([](const std::string_view &value, std::string &out){
+        out.append(value);
+      });
+    }
+
+    /**
+     * If `enabled`, strings are decoded as `std::string_view` referencing the payload instead
+     * of being copied. The views are not visitable as `const std::string &`, so they cannot be
+     * passed to functions expecting strings by reference.
+     */
+    void setStringViews(bool enabled) {
+      add<std::string>(
+        [](const std::string &value, std::string &out){ out.append(value); },
+        enabled ? Decoder([](std::string_view payload){ return Any(payload); }) : Decoder([](std::string_view payload){ return Any(std::string(payload)); })
+      );
+    }
+
+    /**
+     * Adds an encoder and decoder for values of type `T`. `encode` appends the payload to `out`.
+     * Replaces previously added coders for `T`.
+     */
+    template <class T> void add(std::function<void(const T &value, std::string &out)> encode, Decoder decode) {
+      addAlias<T, T>(std::move(encode));
+      decoders[getStaticTypeIndex<T>().hash()] = std::move(decode);
+    }
+
+    /**
+     * Adds an encoder storing values of type `T` as values of type `Encoded`. They are decoded
+     * by the decoder of `Encoded`.
+     */
+    template <class T, class Encoded> void addAlias(std::function<void(const T &value, std::string &out)> encode) {
+      encoders.set(getStaticTypeIndex<T>(), EncoderEntry{
+        getStaticTypeIndex<Encoded>().hash(),
+        [encode = std::move(encode)](const Any &value, std::string &out){ encode(value.get<const T &>(), out); }
+      });
+    }
+
+    /**
+     * Adds a trivially copyable type `T`, which is stored by its object representation and
+     * decoded by reference.
+     */
+    template <class T> void addTrivial() {
+      static_assert(std::is_trivially_copyable<T>::value, "type must be trivially copyable");
+      add<T>(
+        [](const T &value, std::string &out){ any_serializer_detail::append(out, value); },
+        [](std::string_view payload) -> Any {
+          if (payload.size() != sizeof(T)) {
+            throw AnySerializationException("invalid payload size for " + getTypeIndex<T>().name());
+          }
+          if (reinterpret_cast<uintptr_t>(payload.data()) % alignof(T) == 0) {
+            return Any(std::cref(*reinterpret_cast<const T *>(payload.data())));
+          }
+          return Any(any_serializer_detail::read<T>(payload, 0));
+        }
+      );
+    }
+
+    /**
+     * `true`, if values of type `T` can be serialized.
+     */
+    template <class T> bool supports() const {
+      return encoders.contains(getStaticTypeIndex<T>());
+    }
+
+    /**
+     * Appends the entry of a single value to `out`.
+     */
+    void write(const Any &value, std::string &out) const {
+      using namespace any_serializer_detail;
+      if (!value) {
+        append(out, emptyType);
+        append(out, uint64_t(0));
+        return;
+      }
+      auto encoder = encoders.find(value.type());
+      if (!encoder) { throw AnySerializationException("no encoder for type " + value.type().name()); }
+      auto start = out.size();
+      append(out, encoder->type);
+      append(out, uint64_t(0));
+      encoder->encode(value, out);
+      uint64_t size = out.size() - start - entryHeaderSize;
+      std::memcpy(&out[start + sizeof(uint64_t)], &size, sizeof(size));
+      out.append(padding(size), '\0');
+    }
+
+    /**
+     * Reads the entry starting at `offset` in `buffer` and advances `offset` to the next entry.
+     */
+    Any read(std::string_view buffer, size_t &offset) const {
+      using namespace any_serializer_detail;
+      checkSize(buffer, offset, entryHeaderSize);
+      auto type = any_serializer_detail::read<uint64_t>(buffer, offset);
+      auto size = any_serializer_detail::read<uint64_t>(buffer, offset + sizeof(uint64_t));
+      offset += entryHeaderSize;
+      checkSize(buffer, offset, size);
+      auto payload = buffer.substr(offset, size);
+      offset += size + padding(size);
+      if (type == emptyType) { return Any(); }
+      auto decoder = decoders.find(type);
+      if (decoder == decoders.end()) { throw AnySerializationException("unknown type hash " + std::to_string(type)); }
+      return decoder->second(payload);
+    }
+
+    /**
+     * Serializes `values` to a new buffer.
+     */
+    std::string serialize(const std::vector<Any> &values) const {
+      using namespace any_serializer_detail;
+      std::string out(magic, sizeof(magic));
+      append(out, version);
+      append(out, uint64_t(values.size()));
+      for (auto &value: values) { write(value, out); }
+      return out;
+    }
+
+    /**
+     * Deserializes a buffer created by `serialize`. The returned values may reference `buffer`,
+     * which must be aligned to 8 bytes for payloads to be read without copying.
+     */
+    std::vector<Any> deserialize(std::string_view buffer) const {
+      using namespace any_serializer_detail;
+      checkSize(buffer, 0, headerSize);
+      if (buffer.substr(0, sizeof(magic)) != std::string_view(magic, sizeof(magic))) {
+        throw AnySerializationException("invalid buffer");
+      }
+      if (any_serializer_detail::read<uint32_t>(buffer, sizeof(magic)) != version) {
+        throw AnySerializationException("unsupported version");
+      }
+      auto count = any_serializer_detail::read<uint64_t>(buffer, sizeof(magic) + sizeof(uint32_t));
+      if (count > (buffer.size() - headerSize) / entryHeaderSize) { throw AnySerializationException("truncated buffer"); }
+      std::vector<Any> values;
+      values.reserve(count);
+      size_t offset = headerSize;
+      for (uint64_t i = 0; i < count; ++i) { values.emplace_back(read(buffer, offset)); }
+      return values;
+    }
+
+  };
+
+}
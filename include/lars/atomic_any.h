@@ -0,0 +1,208 @@
+#pragma once
+
+#include <lars/any.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace lars {
+
+  namespace atomic_any_detail {
+
+    /**
+     * The epoch announced by a reading thread, or 0 if the thread is not reading.
+     * Aligned to a cache line so that readers do not share lines.
+     */
+    struct alignas(64) ReaderRecord {
+      std::atomic<uint64_t> epoch{0};
+      size_t depth = 0;
+    };
+
+    /**
+     * Epoch-based reclamation shared by all `AtomicAny` objects. Readers announce the current
+     * epoch in their record for the duration of a read. A writer that replaced a value advances
+     * the epoch and waits until no reader announces an older epoch before freeing the value.
+     */
+    class Domain {
+    private:
+      std::atomic<uint64_t> globalEpoch{1};
+      std::mutex mutex;
+      std::vector<ReaderRecord *> readers;
+
+    public:
+      void add(ReaderRecord *record) {
+        std::lock_guard<std::mutex> lock(mutex);
+        readers.push_back(record);
+      }
+
+      void remove(ReaderRecord *record) {
+        std::lock_guard<std::mutex> lock(mutex);
+        readers.erase(std::find(readers.begin(), readers.end(), record));
+      }
+
+      uint64_t epoch() const {
+        return globalEpoch.load();
+      }
+
+      /**
+       * Waits until all reads that started before the call have finished.
+       */
+      void synchronize() {
+        auto target = globalEpoch.fetch_add(1) + 1;
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto reader: readers) {
+          while (true) {
+            auto epoch = reader->epoch.load();
+            if (epoch == 0 || epoch >= target) { break; }
+            std::this_thread::yield();
+          }
+        }
+      }
+    };
+
+    inline Domain &getDomain() {
+      static Domain domain;
+      return domain;
+    }
+
+    struct ThreadRecord {
+      ReaderRecord record;
+      ThreadRecord() { getDomain().add(&record); }
+      ~ThreadRecord() { getDomain().remove(&record); }
+    };
+
+    inline ReaderRecord &getReaderRecord() {
+      static thread_local ThreadRecord current;
+      return current.record;
+    }
+
+    /**
+     * Announces a read for its lifetime. Nested reads keep the outermost announcement.
+     */
+    class ReadGuard {
+    private:
+      ReaderRecord &record;
+
+    public:
+      ReadGuard():record(getReaderRecord()){
+        if (record.depth++ == 0) { record.epoch.store(getDomain().epoch()); }
+      }
+
+      ReadGuard(const ReadGuard &) = delete;
+      ReadGuard &operator=(const ReadGuard &) = delete;
+
+      ~ReadGuard() {
+        if (--record.depth == 0) { record.epoch.store(0, std::memory_order_release); }
+      }
+    };
+
+  }
+
+  /**
+   * Holds an Any value that can be read and replaced concurrently from any number of threads.
+   * Reads are wait-free after the first read of a thread: they announce the current epoch,
+   * copy the reference to the stored value and leave. Writers replace the value atomically and
+   * wait for reads of the previous value to finish before releasing it, so writes are blocking
+   * and should be rare compared to reads.
+   * Note: values must not be written from within `read`, which would wait for itself.
+   */
+  class AtomicAny {
+  private:
+    using Node = AnyReference;
+    std::atomic<Node *> current;
+
+    static Node * makeNode(Any &&value) {
+      auto node = new Node();
+      node->data = std::move(value.data);
+      return node;
+    }
+
+    /**
+     * Frees `node` once no reader can access it anymore.
+     */
+    static void retire(Node *node) {
+      atomic_any_detail::getDomain().synchronize();
+      delete node;
+    }
+
+  public:
+
+    AtomicAny():current(new Node()){ }
+    AtomicAny(Any value):current(makeNode(std::move(value))){ }
+
+    AtomicAny(const AtomicAny &) = delete;
+    AtomicAny &operator=(const AtomicAny &) = delete;
+
+    ~AtomicAny() {
+      delete current.load();
+    }
+
+    /**
+     * Returns a reference to the stored value, which remains valid after the value is replaced.
+     */
+    AnyReference load() const {
+      atomic_any_detail::ReadGuard guard;
+      return *current.load();
+    }
+
+    /**
+     * Calls `f` with the stored value without acquiring a reference to it, which avoids the
+     * reference count contended by `load`. Writers wait for `f` to return, so `f` should be
+     * short. Returns the result of `f`.
+     */
+    template <class F> auto read(F && f) const {
+      atomic_any_detail::ReadGuard guard;
+      return f(std::as_const(*current.load()));
+    }
+
+    /**
+     * Replaces the stored value.
+     */
+    void store(Any value) {
+      exchange(std::move(value));
+    }
+
+    /**
+     * Replaces the stored value and returns the previous value.
+     */
+    AnyReference exchange(Any value) {
+      auto previous = current.exchange(makeNode(std::move(value)));
+      AnyReference result = *previous;
+      retire(previous);
+      return result;
+    }
+
+    /**
+     * Replaces the stored value with `desired` if it is the same object referenced by
+     * `expected`, usually obtained from `load`. Otherwise `expected` is set to the stored value.
+     * Returns `true` if the value has been replaced.
+     */
+    bool compareExchange(AnyReference &expected, Any desired) {
+      Node * previous;
+      {
+        atomic_any_detail::ReadGuard guard;
+        previous = current.load();
+        if (previous->data != expected.data) {
+          expected = *previous;
+          return false;
+        }
+        auto node = makeNode(std::move(desired));
+        if (!current.compare_exchange_strong(previous, node)) {
+          delete node;
+          expected = *previous;
+          return false;
+        }
+      }
+      retire(previous);
+      return true;
+    }
+
+  };
+
+}
@@ -0,0 +1,354 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <lars/any.h>
+#include <lars/visitor.h>
+
+namespace lars {
+
+  namespace bi_visitor_detail {
+
+    template <class Pair> struct PairTypes;
+    template <class A, class B> struct PairTypes<TypeList<A, B>> {
+      static_assert(std::is_reference<A>::value && std::is_reference<B>::value, "BiVisitor pairs must consist of reference types");
+      using First = A;
+      using Second = B;
+    };
+
+    template <class T> constexpr bool isMutableReference() {
+      return !std::is_const<typename std::remove_reference<T>::type>::value;
+    }
+
+    /**
+     * Converts the object to `T` using the `index`th type of its const type set, or of its
+     * mutable type set if `T` is a non-const reference.
+     */
+    template <class T, class V> T fromVisitable(V &visitable, uint32_t index) {
+      using Type = typename std::decay<T>::type;
+      if constexpr (isMutableReference<T>()) {
+        return *static_cast<Type *>(visitable.visitableMutableAddress(index));
+      } else {
+        return *static_cast<const Type *>(visitable.visitableAddress(index));
+      }
+    }
+
+    /**
+     * The position of `hash` in the ordered types of `set` or `-1`.
+     */
+    inline int64_t indexIn(const TypeSet &set, size_t hash) {
+      int64_t i = 0;
+      for (auto h: set) {
+        if (h == hash) { return i; }
+        ++i;
+      }
+      return -1;
+    }
+
+    constexpr uint32_t noPair = uint32_t(-1);
+
+    /**
+     * The type sets of a combination of visitable objects. The mutable type sets are only
+     * set for non-const objects, as types sharing their const types may differ in their
+     * non-const types.
+     */
+    struct Key {
+      const TypeSet * a = nullptr;
+      const TypeSet * b = nullptr;
+      const TypeSet * mutableA = nullptr;
+      const TypeSet * mutableB = nullptr;
+
+      bool operator==(const Key &other) const {
+        return a == other.a && b == other.b && mutableA == other.mutableA && mutableB == other.mutableB;
+      }
+
+      size_t hash() const {
+        auto h = (reinterpret_cast<uintptr_t>(a) >> 3) * 0x9E3779B97F4A7C15ull;
+        h ^= (reinterpret_cast<uintptr_t>(b) >> 3) + 0x632BE59BD9B4E019ull + (h << 6) + (h >> 2);
+        h ^= (reinterpret_cast<uintptr_t>(mutableA) >> 3) + (h << 6) + (h >> 2);
+        h ^= (reinterpret_cast<uintptr_t>(mutableB) >> 3) + (h << 6) + (h >> 2);
+        return size_t(h ^ (h >> 29));
+      }
+    };
+
+    /**
+     * The pair handling a combination of visitable types, and the positions of the pair's
+     * types in the type sets. Non-const reference types are positioned in the mutable type
+     * sets, all other types in the const type sets.
+     */
+    struct Resolution {
+      Key key;
+      uint32_t pair = noPair;
+      uint32_t indexA = 0;
+      uint32_t indexB = 0;
+    };
+
+    /**
+     * An insert-only hash table of resolutions keyed by the type sets of both objects.
+     * Lookups are lock-free. New resolutions are inserted under a mutex and published
+     * atomically; when the table grows, a larger copy is published and the previous one is
+     * kept until destruction, as concurrent lookups may still read it.
+     */
+    class ResolutionTable {
+    private:
+      struct Table {
+        std::vector<std::atomic<const Resolution *>> slots;
+        size_t mask;
+        explicit Table(size_t size):slots(size),mask(size - 1){ }
+      };
+
+      std::atomic<const Table *> current{nullptr};
+      std::mutex mutex;
+      std::vector<std::unique_ptr<Table>> tables;
+      std::vector<std::unique_ptr<Resolution>> resolutions;
+
+      static void place(Table & table, const Resolution * resolution) {
+        for (auto s = resolution->key.hash() & table.mask;; s = (s + 1) & table.mask) {
+          if (!table.slots[s].load(std::memory_order_relaxed)) {
+            table.slots[s].store(resolution, std::memory_order_release);
+            return;
+          }
+        }
+      }
+
+    public:
+
+      /**
+       * Returns the resolution stored for the combination or `nullptr`.
+       */
+      const Resolution * find(const Key &key) const {
+        auto table = current.load(std::memory_order_acquire);
+        if (!table) { return nullptr; }
+        for (auto s = key.hash() & table->mask;; s = (s + 1) & table->mask) {
+          auto resolution = table->slots[s].load(std::memory_order_acquire);
+          if (!resolution) { return nullptr; }
+          if (resolution->key == key) { return resolution; }
+        }
+      }
+
+      /**
+       * Stores the result of `resolve()` for the combination unless it has been stored
+       * concurrently, and returns the stored resolution.
+       */
+      template <class Resolve> const Resolution & insert(const Key &key, const Resolve &resolve) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (auto resolution = find(key)) { return *resolution; }
+        resolutions.push_back(std::make_unique<Resolution>(resolve()));
+        auto table = tables.empty() ? nullptr : tables.back().get();
+        if (!table || resolutions.size() * 2 > table->slots.size()) {
+          tables.push_back(std::make_unique<Table>(table ? table->slots.size() * 2 : 16));
+          for (auto &resolution: resolutions) { place(*tables.back(), resolution.get()); }
+          current.store(tables.back().get(), std::memory_order_release);
+        } else {
+          place(*table, resolutions.back().get());
+        }
+        return *resolutions.back();
+      }
+    };
+
+  }
+
+  template <class A, class B> class SingleBiVisitor {
+  public:
+    /**
+     * The visit method of a bi-visitor.
+     * @param - The first object beeing visited
+     * @param - The second object beeing visited
+     */
+    virtual void visit(A, B) = 0;
+    virtual ~SingleBiVisitor(){}
+  };
+
+  /**
+   * A visitor visiting two visitable objects at once.
+   * Handled pairs are provided as `TypeList<A, B>` template arguments, where `A` and `B`
+   * are reference or const reference types. For every pair, a `visit(A, B)` method must be
+   * implemented.
+   * When visiting, the handled pair is resolved from the types of both objects in the order
+   * of their inheritance lists: all types of the second object are tried for the most
+   * derived type of the first object before its base types are considered. Non-const
+   * references only match objects visited as non-const that expose the type as non-const,
+   * so values only accessible as const, such as an `Any` capturing `std::cref(x)`, are never
+   * passed to them. The resolution is cached per combination of dynamic types in a table
+   * shared by all visitors of the same type, so repeated visits of the same types require a
+   * single lock-free lookup, also for newly created visitors. Besides the lookup, each visit
+   * queries the type set and the converted address of both objects through virtual calls,
+   * so a visit costs about as much as nesting two regular visitors (see the
+   * `BiVisitorDispatch` benchmark). The benefit is a single flat list of handled pairs
+   * instead of one inner visitor per type. Dispatching does not modify the visitor, so it
+   * can be used from several threads at once if its visit methods allow it.
+   * If no pair matches, `visitDefault` is called.
+   */
+  template <typename ... Pairs> class BiVisitor: public SingleBiVisitor<
+    typename bi_visitor_detail::PairTypes<Pairs>::First,
+    typename bi_visitor_detail::PairTypes<Pairs>::Second
+  > ... {
+  private:
+    static_assert(sizeof...(Pairs) > 0, "BiVisitor requires at least one pair");
+
+    using Key = bi_visitor_detail::Key;
+    using Resolution = bi_visitor_detail::Resolution;
+
+    template <class Pair, class V> static void call(BiVisitor * visitor, V &a, V &b, const Resolution &resolution) {
+      using namespace bi_visitor_detail;
+      using A = typename PairTypes<Pair>::First;
+      using B = typename PairTypes<Pair>::Second;
+      if constexpr (!std::is_const<V>::value || !(isMutableReference<A>() || isMutableReference<B>())) {
+        static_cast<SingleBiVisitor<A, B> *>(visitor)->visit(
+          fromVisitable<A>(a, resolution.indexA),
+          fromVisitable<B>(b, resolution.indexB)
+        );
+      }
+    }
+
+    /**
+     * Finds the first handled pair in the inheritance lists of the objects. Pairs of
+     * non-const references require the type to be contained in the mutable type sets.
+     */
+    static Resolution resolve(const Key &key) {
+      using namespace bi_visitor_detail;
+      const size_t first[] = { getStaticTypeIndex<typename PairTypes<Pairs>::First>().hash()... };
+      const size_t second[] = { getStaticTypeIndex<typename PairTypes<Pairs>::Second>().hash()... };
+      const size_t constFirst[] = { getStaticTypeIndex<const typename std::decay<typename PairTypes<Pairs>::First>::type &>().hash()... };
+      const size_t constSecond[] = { getStaticTypeIndex<const typename std::decay<typename PairTypes<Pairs>::Second>::type &>().hash()... };
+      const bool mutableFirst[] = { isMutableReference<typename PairTypes<Pairs>::First>()... };
+      const bool mutableSecond[] = { isMutableReference<typename PairTypes<Pairs>::Second>()... };
+
+      auto position = [](const TypeSet * mutableSet, bool isMutable, size_t hash, int64_t constIndex) -> int64_t {
+        if (!isMutable) { return constIndex; }
+        return mutableSet ? indexIn(*mutableSet, hash) : -1;
+      };
+
+      Resolution resolution;
+      resolution.key = key;
+      int64_t i = 0;
+      for (auto ha: *key.a) {
+        int64_t j = 0;
+        for (auto hb: *key.b) {
+          for (uint32_t p = 0; p < sizeof...(Pairs); ++p) {
+            if (constFirst[p] != ha || constSecond[p] != hb) { continue; }
+            auto indexA = position(key.mutableA, mutableFirst[p], first[p], i);
+            auto indexB = position(key.mutableB, mutableSecond[p], second[p], j);
+            if (indexA < 0 || indexB < 0) { continue; }
+            resolution.pair = p;
+            resolution.indexA = uint32_t(indexA);
+            resolution.indexB = uint32_t(indexB);
+            return resolution;
+          }
+          ++j;
+        }
+        ++i;
+      }
+      return resolution;
+    }
+
+    /**
+     * The resolutions of all visitors of this type.
+     */
+    static bi_visitor_detail::ResolutionTable & getResolutions() {
+      static bi_visitor_detail::ResolutionTable table;
+      return table;
+    }
+
+    static const Resolution & lookup(const Key &key) {
+      auto & resolutions = getResolutions();
+      if (auto resolution = resolutions.find(key)) { return *resolution; }
+      return resolutions.insert(key, [&](){ return resolve(key); });
+    }
+
+    template <class V> void dispatchWith(V &a, V &b, const Key &key) {
+      using Caller = void (*)(BiVisitor *, V &, V &, const Resolution &);
+      static constexpr Caller callers[] = { &call<Pairs, V>... };
+      auto &resolution = lookup(key);
+      if (resolution.pair == bi_visitor_detail::noPair) {
+        visitDefault(a, b);
+      } else {
+        callers[resolution.pair](this, a, b, resolution);
+      }
+    }
+
+  public:
+
+    BiVisitor() = default;
+    BiVisitor(const BiVisitor &) = default;
+    BiVisitor &operator=(const BiVisitor &) = default;
+
+    /**
+     * Called if no pair matches the objects. By default raises an `InvalidVisitorException`
+     * for the first object.
+     */
+    virtual void visitDefault(const VisitableBase &a, const VisitableBase &) {
+      throw InvalidVisitorException(a.visitableType(), getTypeIndex<TypeList<Pairs...>>());
+    }
+
+    /**
+     * Visits `a` and `b` with the first matching pair. Usually called by `visit2`.
+     */
+    void dispatch(VisitableBase &a, VisitableBase &b) {
+      dispatchWith(a, b, Key{
+        &a.visitableTypeSet(), &b.visitableTypeSet(), &a.visitableMutableTypeSet(), &b.visitableMutableTypeSet()
+      });
+    }
+
+    /**
+     * Visits the const objects `a` and `b` with the first matching pair of const references.
+     * Usually called by `visit2`.
+     */
+    void dispatch(const VisitableBase &a, const VisitableBase &b) {
+      dispatchWith(a, b, Key{ &a.visitableTypeSet(), &b.visitableTypeSet() });
+    }
+
+    /**
+     * Visits the values stored in `a` and `b`. Raises an `UndefinedAnyException` if either
+     * is empty. Usually called by `visit2`.
+     */
+    void dispatch(Any &a, Any &b) {
+      if (!a.data || !b.data) { throw UndefinedAnyException(); }
+      dispatch(*a.data, *b.data);
+    }
+
+    void dispatch(const Any &a, const Any &b) {
+      if (!a.data || !b.data) { throw UndefinedAnyException(); }
+      dispatch(std::as_const(*a.data), std::as_const(*b.data));
+    }
+
+  };
+
+  /**
+   * Visits the pair of objects `a` and `b` with `visitor`.
+   */
+  template <typename ... Pairs> void visit2(VisitableBase &a, VisitableBase &b, BiVisitor<Pairs...> &visitor) {
+    visitor.dispatch(a, b);
+  }
+
+  /**
+   * Visits the pair of const objects `a` and `b` with `visitor`. Only pairs of const
+   * references are considered.
+   */
+  template <typename ... Pairs> void visit2(const VisitableBase &a, const VisitableBase &b, BiVisitor<Pairs...> &visitor) {
+    visitor.dispatch(a, b);
+  }
+
+  /**
+   * Visits the values stored in `a` and `b` with `visitor`.
+   */
+  template <typename ... Pairs> void visit2(Any &a, Any &b, BiVisitor<Pairs...> &visitor) {
+    visitor.dispatch(a, b);
+  }
+
+  /**
+   * Visits the values stored in the const objects `a` and `b` with `visitor`. Only pairs of
+   * const references are considered.
+   */
+  template <typename ... Pairs> void visit2(const Any &a, const Any &b, BiVisitor<Pairs...> &visitor) {
+    visitor.dispatch(a, b);
+  }
+
+}
@@ -0,0 +1,345 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <lars/type_map.h>
+#include <lars/visitor.h>
+
+namespace lars {
+
+  namespace dynamic_visitor_detail {
+
+    class HandlersBase {
+    public:
+      virtual SingleVisitorBase * visitor() = 0;
+      virtual std::unique_ptr<HandlersBase> copy() const = 0;
+      virtual TypeIndex type() const = 0;
+
+      /**
+       * Appends the handlers of `other`, which must handle the same type.
+       */
+      virtual void append(const HandlersBase &other) = 0;
+
+      /**
+       * Calls the handlers with `visitable` converted to the handled type, which has been
+       * matched while the visitable's types were walked. Reference types are converted through
+       * the addresses exposed by the visitable, other types by accepting a visitor for the
+       * handled type only.
+       */
+      virtual void visitMatched(const VisitableBase &visitable) = 0;
+
+      virtual ~HandlersBase(){}
+    };
+
+    template <class T> class Handlers final: public HandlersBase, public SingleVisitor<T> {
+    private:
+      using Type = typename std::remove_reference<T>::type;
+
+      /**
+       * Visits the handled type only.
+       */
+      class Single final: public VisitorBase {
+      private:
+        Handlers &owner;
+
+      public:
+        explicit Single(Handlers &o):owner(o){ }
+
+        SingleVisitorBase * getVisitorFor(const StaticTypeIndex &idx) override {
+          return idx == getStaticTypeIndex<T>() ? owner.visitor() : nullptr;
+        }
+
+        void visitDefault(const VisitableBase &) override { }
+
+        TypeIndex visitorType() const override {
+          return getTypeIndex<Handlers>();
+        }
+      };
+
+      static size_t indexIn(const TypeSet &types) {
+        return size_t(std::find(types.begin(), types.end(), getStaticTypeIndex<T>().hash()) - types.begin());
+      }
+
+    public:
+      std::vector<std::function<void(T)>> handlers;
+
+      void visit(T v) override {
+        for (auto &handler: handlers) { handler(static_cast<T>(v)); }
+      }
+
+      SingleVisitorBase * visitor() override {
+        return static_cast<SingleVisitor<T> *>(this);
+      }
+
+      std::unique_ptr<HandlersBase> copy() const override {
+        auto result = std::make_unique<Handlers>();
+        result->handlers = handlers;
+        return result;
+      }
+
+      TypeIndex type() const override {
+        return getTypeIndex<T>();
+      }
+
+      void append(const HandlersBase &other) override {
+        auto &otherHandlers = static_cast<const Handlers &>(other).handlers;
+        handlers.insert(handlers.end(), otherHandlers.begin(), otherHandlers.end());
+      }
+
+      void visitMatched(const VisitableBase &visitable) override {
+        Single single(*this);
+        if constexpr (std::is_reference<T>::value && !std::is_const<Type>::value) {
+          // Non-const references are only listed in the types walked by a non-const accept,
+          // so the visitable is not const.
+          auto &object = const_cast<VisitableBase &>(visitable);
+          if (auto address = object.visitableMutableAddress(indexIn(object.visitableMutableTypeSet()))) {
+            visit(*static_cast<Type *>(address));
+          } else {
+            object.accept(single);
+          }
+        } else if constexpr (std::is_reference<T>::value) {
+          if (auto address = visitable.visitableAddress(indexIn(visitable.visitableTypeSet()))) {
+            visit(*static_cast<Type *>(address));
+          } else {
+            visitable.accept(single);
+          }
+        } else {
+          visitable.accept(single);
+        }
+      }
+    };
+
+  }
+
+  /**
+   * A visitor whose visit methods are registered at runtime.
+   * Handlers are stored in a TypeMap by the StaticTypeIndex of the visited type, so resolving
+   * the handler for a type requires a single lookup. As with `Visitor`, only the handlers of
+   * the first type of the visitable that has handlers registered are called.
+   * If several handlers are registered for the same type, they are called in order of
+   * registration.
+   * Other dynamic visitors can be composed into a visitor as plugins using `add`. A single
+   * `accept` then calls the first matching handlers of this visitor and of every plugin, as
+   * if the visitable had accepted each of them separately. The handlers of all plugins are
+   * merged into one table, from which `getVisitorFor` records the first match of every
+   * plugin while the visitable's types are walked; the matched handlers are called in
+   * `visitDefault` once the walk has finished.
+   */
+  class DynamicVisitor: public VisitorBase {
+  private:
+    struct Entry {
+      SingleVisitorBase * visitor;
+      std::unique_ptr<dynamic_visitor_detail::HandlersBase> handlers;
+    };
+
+    /**
+     * Handlers of the plugin with position `plugin`, where this visitor's own handlers are
+     * at position 0.
+     */
+    struct Match {
+      uint32_t plugin;
+      dynamic_visitor_detail::HandlersBase * handlers;
+    };
+
+    TypeMap<Entry> entries;
+    std::vector<DynamicVisitor> plugins;
+    TypeMap<std::vector<Match>> merged;
+
+    /**
+     * The matches recorded by `getVisitorFor` for the current walk start at `walkBegin`.
+     * Matches of nested walks, started by handlers, are appended and removed again.
+     */
+    std::vector<Match> matches;
+    size_t walkBegin = 0;
+
+    void checkMutable() const {
+      if (entries.isFrozen()) { throw FrozenTypeMapException(); }
+    }
+
+    void addHandlers(const StaticTypeIndex &idx, const dynamic_visitor_detail::HandlersBase &handlers) {
+      if (auto entry = entries.find(idx)) {
+        entry->handlers->append(handlers);
+      } else {
+        auto copy = handlers.copy();
+        auto visitor = copy->visitor();
+        entries.emplace(idx, Entry{visitor, std::move(copy)});
+      }
+    }
+
+    /**
+     * Rebuilds the table of all handlers by type from the own handlers and the plugins.
+     */
+    void merge() {
+      merged = TypeMap<std::vector<Match>>();
+      if (plugins.empty()) { return; }
+      auto mergeEntries = [&](const TypeMap<Entry> &source, uint32_t plugin) {
+        for (auto &entry: source) { merged[entry.first].push_back(Match{plugin, entry.second.handlers.get()}); }
+      };
+      mergeEntries(entries, 0);
+      for (size_t i = 0; i < plugins.size(); ++i) { mergeEntries(plugins[i].entries, uint32_t(i + 1)); }
+    }
+
+    /**
+     * Raises an `InvalidVisitorException` listing the registered types.
+     */
+    [[noreturn]] void raiseInvalidVisitor(const VisitableBase &visitable) const {
+      std::vector<std::string_view> names;
+      for (auto &entry: entries) { names.push_back(getPrettyTypeName(entry.second.handlers->type())); }
+      for (auto &entry: merged) { names.push_back(getPrettyTypeName(entry.second.front().handlers->type())); }
+      std::sort(names.begin(), names.end());
+      names.erase(std::unique(names.begin(), names.end()), names.end());
+      std::string expected;
+      for (auto &name: names) {
+        if (!expected.empty()) { expected += ", "; }
+        expected += name;
+      }
+      throw InvalidVisitorException(visitable.visitableType(), visitorType(), expected);
+    }
+
+  public:
+
+    DynamicVisitor() = default;
+    DynamicVisitor(DynamicVisitor &&) = default;
+    DynamicVisitor &operator=(DynamicVisitor &&) = default;
+
+    DynamicVisitor(const DynamicVisitor &other): VisitorBase(), plugins(other.plugins) {
+      for (auto &entry: other.entries) {
+        addHandlers(entry.first, *entry.second.handlers);
+      }
+      merge();
+    }
+
+    DynamicVisitor &operator=(const DynamicVisitor &other) {
+      if (this != &other) {
+        *this = DynamicVisitor(other);
+      }
+      return *this;
+    }
+
+    /**
+     * Registers `handler` as a visit method for the type `T`, usually a reference or
+     * const reference. Raises a `FrozenTypeMapException` if the visitor is frozen.
+     */
+    template <class T, class F> DynamicVisitor & add(F && handler) {
+      checkMutable();
+      auto idx = getStaticTypeIndex<T>();
+      if (auto entry = entries.find(idx)) {
+        static_cast<dynamic_visitor_detail::Handlers<T> &>(*entry->handlers).handlers.emplace_back(std::forward<F>(handler));
+      } else {
+        auto handlers = std::make_unique<dynamic_visitor_detail::Handlers<T>>();
+        handlers->handlers.emplace_back(std::forward<F>(handler));
+        auto visitor = handlers->visitor();
+        entries.emplace(idx, Entry{visitor, std::move(handlers)});
+        merge();
+      }
+      return *this;
+    }
+
+    /**
+     * Adds copies of the handlers and plugins of `other` as plugins, called after the
+     * handlers of this visitor and of previously added plugins. When accepted, each plugin
+     * calls the handlers of its own first matching type, so if this visitor handles `B &`
+     * and `other` only a base `A &`, visiting a `B` calls both handlers. Raises a
+     * `FrozenTypeMapException` if the visitor is frozen.
+     */
+    DynamicVisitor & add(const DynamicVisitor &other) {
+      checkMutable();
+      std::vector<DynamicVisitor> added;
+      if (!other.entries.empty()) {
+        added.emplace_back();
+        for (auto &entry: other.entries) { added.back().addHandlers(entry.first, *entry.second.handlers); }
+      }
+      added.insert(added.end(), other.plugins.begin(), other.plugins.end());
+      for (auto &plugin: added) { plugins.push_back(std::move(plugin)); }
+      merge();
+      return *this;
+    }
+
+    /**
+     * `true`, if this visitor or one of its plugins has handlers registered for `idx`.
+     */
+    bool handles(const StaticTypeIndex &idx) const {
+      return entries.contains(idx) || merged.contains(idx);
+    }
+
+    /**
+     * `true`, if handlers are registered for the type `T`.
+     */
+    template <class T> bool handles() const {
+      return handles(getStaticTypeIndex<T>());
+    }
+
+    /**
+     * The number of types with registered handlers.
+     */
+    size_t size() const {
+      return plugins.empty() ? entries.size() : merged.size();
+    }
+
+    /**
+     * Compacts the handler tables and prevents further registrations.
+     */
+    void freeze() {
+      entries.freeze();
+      for (auto &plugin: plugins) { plugin.freeze(); }
+      merged.freeze();
+    }
+
+    /**
+     * Returns the visitor for `idx`. Visitors with plugins record the handlers of the plugins
+     * that match `idx` first and return `nullptr`, so that the walk continues and ends in
+     * `visitDefault`.
+     */
+    SingleVisitorBase * getVisitorFor(const StaticTypeIndex &idx) override {
+      if (plugins.empty()) {
+        auto entry = entries.find(idx);
+        return entry ? entry->visitor : nullptr;
+      }
+      if (auto found = merged.find(idx)) {
+        for (auto &match: *found) {
+          auto begin = matches.begin() + walkBegin;
+          if (std::none_of(begin, matches.end(), [&](auto &m){ return m.plugin == match.plugin; })) {
+            matches.push_back(match);
+          }
+        }
+      }
+      return nullptr;
+    }
+
+    TypeIndex visitorType() const override {
+      return getTypeIndex<DynamicVisitor>();
+    }
+
+    /**
+     * Calls the handlers matched by the plugins in order. Raises an `InvalidVisitorException`
+     * listing the registered types if no handler matches.
+     */
+    void visitDefault(const VisitableBase &visitable) override {
+      auto begin = walkBegin, end = matches.size();
+      if (begin == end) { raiseInvalidVisitor(visitable); }
+      struct Restore {
+        DynamicVisitor &visitor;
+        size_t begin;
+        ~Restore() {
+          visitor.matches.resize(begin);
+          visitor.walkBegin = begin;
+        }
+      } restore{*this, begin};
+      walkBegin = end;
+      std::sort(matches.begin() + begin, matches.end(), [](auto &a, auto &b){ return a.plugin < b.plugin; });
+      for (auto i = begin; i < end; ++i) {
+        matches[i].handlers->visitMatched(visitable);
+      }
+    }
+
+  };
+
+}
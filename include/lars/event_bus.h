@@ -0,0 +1,420 @@
+#pragma once
+
+#include <lars/any.h>
+#include <lars/dynamic_visitor.h>
+#include <lars/type_map.h>
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace lars {
+
+  namespace event_bus_detail {
+
+    struct Node {
+      std::atomic<Node *> next{nullptr};
+      AnyReference value;
+    };
+
+    /**
+     * The unbounded multi-producer, single-consumer queue of D. Vyukov. Producers append a
+     * chain of nodes with a single atomic exchange. The consumer owns `tail`, a stub node whose
+     * successor is the next message.
+     */
+    class Queue {
+    private:
+      alignas(64) std::atomic<Node *> head;
+      alignas(64) Node * tail;
+
+    public:
+      Queue() {
+        tail = new Node();
+        head.store(tail, std::memory_order_relaxed);
+      }
+
+      Queue(const Queue &) = delete;
+      Queue &operator=(const Queue &) = delete;
+
+      ~Queue() {
+        AnyReference value;
+        while (pop(value)) { }
+        delete tail;
+      }
+
+      /**
+       * Appends the nodes from `first` to `last`, linked by `next`.
+       */
+      void push(Node * first, Node * last) {
+        last->next.store(nullptr, std::memory_order_relaxed);
+        auto previous = head.exchange(last, std::memory_order_acq_rel);
+        previous->next.store(first, std::memory_order_release);
+      }
+
+      /**
+       * Called by the consumer only.
+       */
+      bool pop(AnyReference &value) {
+        auto next = tail->next.load(std::memory_order_acquire);
+        if (!next) { return false; }
+        value = next->value;
+        next->value.reset();
+        delete tail;
+        tail = next;
+        return true;
+      }
+
+      bool empty() const {
+        return tail->next.load(std::memory_order_acquire) == nullptr;
+      }
+    };
+
+    /**
+     * Nodes linked for a single push.
+     */
+    struct Chain {
+      Node * first = nullptr;
+      Node * last = nullptr;
+
+      void append(Node * node) {
+        if (last) { last->next.store(node, std::memory_order_relaxed); } else { first = node; }
+        last = node;
+      }
+    };
+
+    /**
+     * Visits a value without calling a handler to collect its types in inheritance order.
+     */
+    class TypeCollector final: public VisitorBase {
+    public:
+      std::vector<StaticTypeIndex> types;
+
+      SingleVisitorBase * getVisitorFor(const StaticTypeIndex &idx) override {
+        types.push_back(idx);
+        return nullptr;
+      }
+
+      void visitDefault(const VisitableBase &) override { }
+
+      TypeIndex visitorType() const override {
+        return getTypeIndex<TypeCollector>();
+      }
+    };
+
+    /**
+     * Reclamation of the routing table of a single bus, independent of other buses and of
+     * `AtomicAny`. A reader increments a counter of the current phase for the duration of a
+     * read; the counter is chosen by the thread to spread contention. `synchronize` switches
+     * the phase and waits for the counters of the previous phase to drain, twice, so that
+     * readers that incremented a counter of either phase before the call have finished.
+     */
+    class Domain {
+    private:
+      static constexpr size_t stripes = 16;
+
+      struct alignas(64) Counter {
+        std::atomic<size_t> readers{0};
+      };
+
+      std::atomic<size_t> phase{0};
+      Counter counters[2][stripes];
+
+      static size_t stripe() {
+        static thread_local size_t index = std::hash<std::thread::id>()(std::this_thread::get_id()) % stripes;
+        return index;
+      }
+
+    public:
+
+      /**
+       * Announces a read for its lifetime.
+       */
+      class ReadGuard {
+      private:
+        Counter &counter;
+
+      public:
+        explicit ReadGuard(Domain &domain):counter(domain.counters[domain.phase.load() & 1][stripe()]){
+          counter.readers.fetch_add(1);
+        }
+
+        ReadGuard(const ReadGuard &) = delete;
+        ReadGuard &operator=(const ReadGuard &) = delete;
+
+        ~ReadGuard() {
+          counter.readers.fetch_sub(1, std::memory_order_release);
+        }
+      };
+
+      /**
+       * Waits until all reads that started before the call have finished. Must not be called
+       * concurrently or during a read.
+       */
+      void synchronize() {
+        for (int i = 0; i < 2; ++i) {
+          auto previous = phase.fetch_add(1) & 1;
+          for (auto &counter: counters[previous]) {
+            while (counter.readers.load() != 0) { std::this_thread::yield(); }
+          }
+        }
+      }
+    };
+
+  }
+
+  /**
+   * Delivers published Any values to the subscribers handling their type.
+   * Subscribers register handlers in a `DynamicVisitor` for types such as `const T &`, and
+   * receive values of `T` and of types derived from `T`, using the first handled type in the
+   * inheritance order of the value. The subscribers of a type are resolved once and cached
+   * in a table keyed by the type of the published value, which is updated when subscribers
+   * change. Values are passed to every matching subscriber through a lock-free queue, and
+   * delivered when the subscriber calls `poll` on its own thread.
+   * Publishing values of known types does not lock; the first value of a type and changes
+   * of subscribers update the table under a mutex and wait for concurrent publishers of the
+   * same bus. The table is reclaimed independently of `AtomicAny`, so the bus can also be
+   * used while reading an `AtomicAny`.
+   */
+  class EventBus {
+  public:
+
+    class Subscriber {
+    private:
+      friend class EventBus;
+      DynamicVisitor handlers;
+      event_bus_detail::Queue queue;
+
+    public:
+      explicit Subscriber(DynamicVisitor h):handlers(std::move(h)){
+        handlers.freeze();
+      }
+
+      /**
+       * Calls the handlers for up to `maxMessages` pending values in order of publication.
+       * Only one thread may poll a subscriber at a time.
+       * Returns the number of delivered values.
+       */
+      size_t poll(size_t maxMessages = std::numeric_limits<size_t>::max()) {
+        AnyReference value;
+        size_t count = 0;
+        while (count < maxMessages && queue.pop(value)) {
+          std::as_const(value).accept(handlers);
+          ++count;
+        }
+        return count;
+      }
+
+      /**
+       * `true`, if no values are pending.
+       */
+      bool empty() const {
+        return queue.empty();
+      }
+    };
+
+  private:
+    struct Route {
+      std::vector<StaticTypeIndex> types;
+      std::vector<Subscriber *> subscribers;
+    };
+
+    struct Table {
+      TypeMap<Route> routes;
+    };
+
+    std::mutex mutex;
+    std::vector<std::shared_ptr<Subscriber>> subscribers;
+    std::atomic<Table *> table;
+    event_bus_detail::Domain domain;
+
+    static bool handles(Subscriber &subscriber, const std::vector<StaticTypeIndex> &types) {
+      return std::any_of(types.begin(), types.end(), [&](auto &idx){ return subscriber.handlers.handles(idx); });
+    }
+
+    /**
+     * Installs `next` and frees the previous table once no publisher can access it.
+     * Called with `mutex` locked.
+     */
+    void replaceTable(Table * next) {
+      auto previous = table.exchange(next);
+      domain.synchronize();
+      delete previous;
+    }
+
+    /**
+     * Installs a copy of the current table with `update` applied to every route.
+     * Called with `mutex` locked.
+     */
+    template <class F> void updateRoutes(F && update) {
+      auto next = new Table();
+      for (auto &entry: table.load()->routes) {
+        auto route = entry.second;
+        update(route);
+        next->routes.emplace(entry.first, std::move(route));
+      }
+      replaceTable(next);
+    }
+
+    /**
+     * Adds the route for the type of `value` to the table.
+     */
+    void resolve(const Any &value) {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto current = table.load();
+      if (current->routes.contains(value.type())) { return; }
+      event_bus_detail::TypeCollector collector;
+      value.accept(collector);
+      Route route{std::move(collector.types), {}};
+      for (auto &subscriber: subscribers) {
+        if (handles(*subscriber, route.types)) { route.subscribers.push_back(subscriber.get()); }
+      }
+      auto next = new Table(*current);
+      next->routes.emplace(value.type(), std::move(route));
+      replaceTable(next);
+    }
+
+    static event_bus_detail::Node * makeNode(const Any &value) {
+      auto node = new event_bus_detail::Node();
+      node->value = value;
+      return node;
+    }
+
+    using Chains = std::vector<std::pair<Subscriber *, event_bus_detail::Chain>>;
+
+    /**
+     * Appends a node for `value` to the chain of every subscriber. The nodes are linked only
+     * after all allocations succeeded, so `chains` is unchanged if an exception is raised.
+     */
+    static void appendNodes(Chains &chains, const std::vector<Subscriber *> &subscribers, const Any &value) {
+      std::vector<std::unique_ptr<event_bus_detail::Node>> nodes;
+      nodes.reserve(subscribers.size());
+      for (size_t i = 0; i < subscribers.size(); ++i) { nodes.emplace_back(makeNode(value)); }
+      auto findChain = [&](Subscriber *subscriber){
+        return std::find_if(chains.begin(), chains.end(), [&](auto &c){ return c.first == subscriber; });
+      };
+      for (auto subscriber: subscribers) {
+        if (findChain(subscriber) == chains.end()) { chains.emplace_back(subscriber, event_bus_detail::Chain()); }
+      }
+      for (size_t i = 0; i < subscribers.size(); ++i) {
+        findChain(subscribers[i])->second.append(nodes[i].release());
+      }
+    }
+
+    static void pushChains(Chains &chains) {
+      for (auto &chain: chains) {
+        if (chain.second.first) { chain.first->queue.push(chain.second.first, chain.second.last); }
+      }
+      chains.clear();
+    }
+
+  public:
+
+    EventBus():table(new Table()){ }
+
+    EventBus(const EventBus &) = delete;
+    EventBus &operator=(const EventBus &) = delete;
+
+    ~EventBus() {
+      delete table.load();
+    }
+
+    /**
+     * Adds a subscriber calling `handlers` for values of the handled types.
+     */
+    std::shared_ptr<Subscriber> subscribe(DynamicVisitor handlers) {
+      auto subscriber = std::make_shared<Subscriber>(std::move(handlers));
+      std::lock_guard<std::mutex> lock(mutex);
+      subscribers.push_back(subscriber);
+      updateRoutes([&](Route &route){
+        if (handles(*subscriber, route.types)) { route.subscribers.push_back(subscriber.get()); }
+      });
+      return subscriber;
+    }
+
+    /**
+     * Adds a subscriber calling `handler` for values of type `T`, usually a const reference.
+     */
+    template <class T, class F> std::shared_ptr<Subscriber> subscribe(F && handler) {
+      DynamicVisitor handlers;
+      handlers.add<T>(std::forward<F>(handler));
+      return subscribe(std::move(handlers));
+    }
+
+    /**
+     * Removes `subscriber`. No values are passed to the subscriber after the call returns;
+     * pending values can still be polled.
+     */
+    void unsubscribe(const std::shared_ptr<Subscriber> &subscriber) {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = std::find(subscribers.begin(), subscribers.end(), subscriber);
+      if (it == subscribers.end()) { return; }
+      subscribers.erase(it);
+      updateRoutes([&](Route &route){
+        route.subscribers.erase(std::remove(route.subscribers.begin(), route.subscribers.end(), subscriber.get()), route.subscribers.end());
+      });
+    }
+
+    /**
+     * Passes `value` to all subscribers handling its type.
+     * Raises an `UndefinedAnyException` if `value` is empty.
+     */
+    void publish(const Any &value) {
+      if (!value) { throw UndefinedAnyException(); }
+      while (true) {
+        {
+          event_bus_detail::Domain::ReadGuard guard(domain);
+          if (auto route = table.load()->routes.find(value.type())) {
+            for (auto subscriber: route->subscribers) {
+              auto node = makeNode(value);
+              subscriber->queue.push(node, node);
+            }
+            return;
+          }
+        }
+        resolve(value);
+      }
+    }
+
+    /**
+     * Passes the values from `begin` to `end` to their subscribers. The values for a subscriber
+     * are appended to its queue with a single atomic operation.
+     * Raises an `UndefinedAnyException` if a value is empty. If a value is empty or an
+     * exception is raised while reading or copying a value, the preceding values are
+     * published before the exception is propagated.
+     */
+    template <class Iterator> void publish(Iterator begin, Iterator end) {
+      Chains chains;
+      while (begin != end) {
+        {
+          event_bus_detail::Domain::ReadGuard guard(domain);
+          auto current = table.load();
+          try {
+            for (; begin != end; ++begin) {
+              const Any &value = *begin;
+              auto route = current->routes.find(value.type());
+              if (!route || !value) { break; }
+              appendNodes(chains, route->subscribers, value);
+            }
+          } catch (...) {
+            pushChains(chains);
+            throw;
+          }
+          pushChains(chains);
+        }
+        if (begin != end) {
+          const Any &value = *begin;
+          if (!value) { throw UndefinedAnyException(); }
+          resolve(value);
+        }
+      }
+    }
+
+  };
+
+}
@@ -0,0 +1,281 @@
+#pragma once
+
+#include <lars/any_function.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace lars {
+
+  /**
+   * Is raised when a function registry does not contain a requested function
+   */
+  class UnknownFunctionException: public std::exception {
+  private:
+    std::string buffer;
+
+  public:
+    UnknownFunctionException(std::string_view name):buffer("unknown function: " + std::string(name)){ }
+
+    const char * what() const noexcept override {
+      return buffer.c_str();
+    }
+  };
+
+  /**
+   * Is raised when adding a function to a frozen registry or when adding a name twice
+   */
+  class InvalidFunctionRegistrationException: public std::exception {
+  private:
+    std::string buffer;
+
+  public:
+    InvalidFunctionRegistrationException(std::string_view name, bool frozen):buffer(
+      (frozen ? "cannot add function to frozen registry: " : "function already registered: ") + std::string(name)
+    ){ }
+
+    const char * what() const noexcept override {
+      return buffer.c_str();
+    }
+  };
+
+  /**
+   * Identifies a function in a `FunctionRegistry`. Handles are indices into the registry and
+   * remain valid for the lifetime of the registry.
+   */
+  struct FunctionHandle {
+    static constexpr uint32_t invalidIndex = std::numeric_limits<uint32_t>::max();
+    uint32_t index = invalidIndex;
+
+    explicit operator bool() const { return index != invalidIndex; }
+    bool operator==(const FunctionHandle &other) const { return index == other.index; }
+    bool operator!=(const FunctionHandle &other) const { return index != other.index; }
+  };
+
+  /**
+   * Stores named AnyFunctions.
+   * While functions are being added, all access is synchronized by a mutex. After calling
+   * `freeze()` the registry becomes immutable and names are resolved using a perfect hash
+   * table, requiring a single hash and probe per lookup. Reads on a frozen registry are lock-free.
+   */
+  class FunctionRegistry {
+  public:
+    struct Entry {
+      std::string name;
+      AnyFunction function;
+      AnyFunctionSignature signature;
+    };
+
+  private:
+    struct Slot {
+      uint64_t hash = 0;
+      uint32_t index = FunctionHandle::invalidIndex;
+    };
+
+    std::deque<Entry> entries;
+    std::unordered_map<std::string_view, uint32_t> names;
+    mutable std::mutex mutex;
+    std::atomic<bool> frozen{false};
+
+    std::vector<Slot> slots;
+    std::vector<uint32_t> displacements;
+    uint64_t seed = 0;
+
+    static uint64_t hash(std::string_view name, uint64_t seed) {
+      uint64_t h = 14695981039346656037ull ^ (seed * 0x9E3779B97F4A7C15ull);
+      for (auto c: name) {
+        h ^= static_cast<unsigned char>(c);
+        h *= 1099511628211ull;
+      }
+      return h ^ (h >> 29);
+    }
+
+    static size_t nextPowerOfTwo(size_t v) {
+      size_t p = 1;
+      while (p < v) { p <<= 1; }
+      return p;
+    }
+
+    size_t bucketOf(uint64_t h) const {
+      return (h >> 32) & (displacements.size() - 1);
+    }
+
+    size_t slotOf(uint64_t h, uint32_t displacement) const {
+      auto step = (h >> 32) | 1;
+      return (h + displacement * step) & (slots.size() - 1);
+    }
+
+    /**
+     * Tries to find displacements for all buckets using the hash-and-displace algorithm.
+     */
+    bool buildPerfectHash() {
+      std::vector<std::vector<std::pair<uint64_t, uint32_t>>> buckets(displacements.size());
+      for (uint32_t i = 0; i < entries.size(); ++i) {
+        auto h = hash(entries[i].name, seed);
+        buckets[bucketOf(h)].emplace_back(h, i);
+      }
+
+      std::vector<uint32_t> order(buckets.size());
+      for (uint32_t i = 0; i < order.size(); ++i) { order[i] = i; }
+      std::stable_sort(order.begin(), order.end(), [&](auto a, auto b){ return buckets[a].size() > buckets[b].size(); });
+
+      std::vector<size_t> candidate;
+      for (auto b: order) {
+        auto & bucket = buckets[b];
+        if (bucket.empty()) { break; }
+        bool placed = false;
+        for (uint32_t d = 0; d < slots.size() && !placed; ++d) {
+          candidate.clear();
+          placed = true;
+          for (auto & key: bucket) {
+            auto s = slotOf(key.first, d);
+            if (slots[s].index != FunctionHandle::invalidIndex || std::find(candidate.begin(), candidate.end(), s) != candidate.end()) {
+              placed = false;
+              break;
+            }
+            candidate.push_back(s);
+          }
+          if (placed) {
+            displacements[b] = d;
+            for (size_t i = 0; i < bucket.size(); ++i) {
+              slots[candidate[i]] = Slot{bucket[i].first, bucket[i].second};
+            }
+          }
+        }
+        if (!placed) { return false; }
+      }
+      return true;
+    }
+
+    FunctionHandle findFrozen(std::string_view name) const {
+      auto h = hash(name, seed);
+      auto & slot = slots[slotOf(h, displacements[bucketOf(h)])];
+      if (slot.hash == h && slot.index != FunctionHandle::invalidIndex && entries[slot.index].name == name) {
+        return FunctionHandle{slot.index};
+      }
+      return FunctionHandle();
+    }
+
+    const Entry & entry(FunctionHandle handle) const {
+      if (frozen.load(std::memory_order_acquire)) {
+        if (handle.index >= entries.size()) { throw UnknownFunctionException("<invalid handle>"); }
+        return entries[handle.index];
+      }
+      std::lock_guard<std::mutex> lock(mutex);
+      if (handle.index >= entries.size()) { throw UnknownFunctionException("<invalid handle>"); }
+      return entries[handle.index];
+    }
+
+  public:
+
+    FunctionRegistry() = default;
+    FunctionRegistry(const FunctionRegistry &) = delete;
+    FunctionRegistry &operator=(const FunctionRegistry &) = delete;
+
+    /**
+     * Adds a function to the registry and returns its handle.
+     * Raises an `InvalidFunctionRegistrationException` if the registry is frozen or if
+     * the name has already been registered.
+     */
+    FunctionHandle add(std::string_view name, AnyFunction function) {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (frozen.load(std::memory_order_relaxed)) { throw InvalidFunctionRegistrationException(name, true); }
+      if (names.find(name) != names.end()) { throw InvalidFunctionRegistrationException(name, false); }
+      if (entries.size() == FunctionHandle::invalidIndex) { throw InvalidFunctionRegistrationException(name, false); }
+      AnyFunctionSignature signature = function ? function.signature() : AnyFunctionSignature{getStaticTypeIndex<void>(), nullptr, 0, false};
+      entries.push_back(Entry{std::string(name), std::move(function), signature});
+      auto index = static_cast<uint32_t>(entries.size() - 1);
+      names.emplace(entries.back().name, index);
+      return FunctionHandle{index};
+    }
+
+    /**
+     * Builds the perfect hash table and makes the registry immutable.
+     * Calling `freeze()` on a frozen registry has no effect.
+     */
+    void freeze() {
+      std::lock_guard<std::mutex> lock(mutex);
+      if (frozen.load(std::memory_order_relaxed)) { return; }
+      auto slotCount = nextPowerOfTwo(std::max<size_t>(entries.size() + entries.size() / 4, 1));
+      displacements.resize(nextPowerOfTwo(entries.size() / 4 + 1));
+      for (seed = 0;; ++seed) {
+        slots.assign(slotCount, Slot());
+        std::fill(displacements.begin(), displacements.end(), 0);
+        if (buildPerfectHash()) { break; }
+        if (seed % 16 == 15) { slotCount *= 2; }
+      }
+      names.clear();
+      frozen.store(true, std::memory_order_release);
+    }
+
+    /**
+     * `true`, if `freeze()` has been called.
+     */
+    bool isFrozen() const {
+      return frozen.load(std::memory_order_acquire);
+    }
+
+    /**
+     * The number of registered functions.
+     */
+    size_t size() const {
+      if (isFrozen()) { return entries.size(); }
+      std::lock_guard<std::mutex> lock(mutex);
+      return entries.size();
+    }
+
+    /**
+     * Returns the handle of the function registered as `name` or an invalid handle if
+     * no such function exists.
+     */
+    FunctionHandle find(std::string_view name) const {
+      if (isFrozen()) { return findFrozen(name); }
+      std::lock_guard<std::mutex> lock(mutex);
+      auto it = names.find(name);
+      return it == names.end() ? FunctionHandle() : FunctionHandle{it->second};
+    }
+
+    /**
+     * Same as `find`, but raises an `UnknownFunctionException` if no such function exists.
+     */
+    FunctionHandle handle(std::string_view name) const {
+      auto h = find(name);
+      if (!h) { throw UnknownFunctionException(name); }
+      return h;
+    }
+
+    const AnyFunction & get(FunctionHandle handle) const {
+      return entry(handle).function;
+    }
+
+    const AnyFunction & get(std::string_view name) const {
+      return get(handle(name));
+    }
+
+    const AnyFunctionSignature & signature(FunctionHandle handle) const {
+      return entry(handle).signature;
+    }
+
+    const std::string & name(FunctionHandle handle) const {
+      return entry(handle).name;
+    }
+
+    template <typename ... Args> Any operator()(FunctionHandle handle, Args && ... args) const {
+      return get(handle)(std::forward<Args>(args)...);
+    }
+
+    template <typename ... Args> Any operator()(std::string_view name, Args && ... args) const {
+      return get(name)(std::forward<Args>(args)...);
+    }
+
+  };
+
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <type_traits>
+#include <utility>
 
 #include <lars/type_list.h>
 #include <lars/type_index.h>
@@ -13,98 +14,122 @@ namespace lars {
   };
   
   template <class OStream, class T, unsigned O> OStream & operator<<(OStream &stream, const OrderedType<T,O> &){
-    stream << '[' << lars::get_type_name<T>() << ',' << O << ']';
+    stream << '[' << lars::getTypeIndex<T>().nameView() << ',' << O << ']';
     return stream;
   }
 
   template <typename ... OrderedTypes> struct InheritanceList;
-  
-  template <class T, class Previous, class List> struct InheritanceListRemover;
-  template <class T, typename ... Previous> struct InheritanceListRemover <
-    T,
-    InheritanceList<Previous...>,
-    InheritanceList<>
-  > {
-    using type = InheritanceList<Previous...>;
-    const static unsigned value = 0;
-  };
-  template <class T, typename ... Previous, class FT, unsigned FO, typename ... Rest> struct InheritanceListRemover <
-    T,
-    InheritanceList<Previous...>,
-    InheritanceList<OrderedType<FT, FO>, Rest ...>
-  > {
-  private:
-    using RemoverType = typename std::conditional<
-      std::is_same<T, FT>::value,
-      InheritanceListRemover<
-        T,
-        InheritanceList<Previous..., Rest...>,
-        InheritanceList<>
-      >,
-      InheritanceListRemover<
-        T,
-        InheritanceList<Previous..., OrderedType<FT, FO>>,
-        InheritanceList<Rest...>
-      >
-    >::type;
+
+  namespace inheritance_list {
+
+    struct Entry {
+      size_t source = 0;
+      unsigned order = 0;
+    };
+
+    template <size_t N> struct Entries {
+      Entry values[N + 1] = {};
+      size_t size = 0;
+
+      /**
+       * Removes the entry with the same type as `entry` and inserts `entry` in front of the
+       * first entry with a lower or equal order. If the type was already contained, the larger
+       * of the two orders is kept.
+       */
+      constexpr void push(Entry entry, const size_t * ids) {
+        size_t count = 0;
+        for (size_t i = 0; i < size; ++i) {
+          if (ids[values[i].source] == ids[entry.source]) {
+            if (values[i].order > entry.order) { entry.order = values[i].order; }
+          } else {
+            values[count++] = values[i];
+          }
+        }
+        size_t position = 0;
+        while (position < count && values[position].order > entry.order) { ++position; }
+        for (size_t i = count; i > position; --i) { values[i] = values[i - 1]; }
+        values[position] = entry;
+        size = count + 1;
+      }
+    };
+
+    /**
+     * Index of the first element in `Types` that is equal to `T`.
+     */
+    template <class T, typename ... Types> constexpr size_t firstIndex() {
+      const bool same[] = { std::is_same_v<T, Types>..., true };
+      size_t index = 0;
+      while (!same[index]) { ++index; }
+      return index;
+    }
+
+    template <typename ... Lists> struct Concat;
+    template <> struct Concat<> { using type = InheritanceList<>; };
+    template <typename ... A> struct Concat<InheritanceList<A...>> { using type = InheritanceList<A...>; };
+    template <typename ... A, typename ... B, typename ... Rest> struct Concat<InheritanceList<A...>, InheritanceList<B...>, Rest...> {
+      using type = typename Concat<InheritanceList<A..., B...>, Rest...>::type;
+    };
+
+    /**
+     * Merges the consecutive segments of sizes `Sizes` of the InheritanceList `Pool`.
+     * Starting from the first segment, the elements of the current result are pushed in order
+     * into the next segment. The merge is evaluated on indices in a single constexpr function,
+     * so that only the resulting InheritanceList has to be instantiated.
+     */
+    template <class Pool, size_t ... Sizes> struct Merge;
+    template <typename ... Types, unsigned ... Orders, size_t ... Sizes> struct Merge<
+      InheritanceList<OrderedType<Types, Orders>...>,
+      Sizes...
+    > {
+    private:
+      static constexpr size_t count = sizeof...(Types);
+
+      static constexpr Entries<count> entries = []{
+        const size_t ids[] = { firstIndex<Types, Types...>()..., 0 };
+        const unsigned orders[] = { Orders..., 0 };
+        const size_t sizes[] = { Sizes..., 0 };
+        Entries<count> result;
+        size_t offset = 0;
+        for (size_t segment = 0; segment < sizeof...(Sizes); ++segment) {
+          Entries<count> previous = result;
+          result.size = sizes[segment];
+          for (size_t i = 0; i < sizes[segment]; ++i) { result.values[i] = Entry{offset + i, orders[offset + i]}; }
+          offset += sizes[segment];
+          for (size_t i = 0; i < previous.size; ++i) { result.push(previous.values[i], ids); }
+        }
+        return result;
+      }();
+
+      using Indexer = typelist::Indexer<Types...>;
+
+      template <class Sequence> struct Build;
+      template <size_t ... I> struct Build<std::index_sequence<I...>> {
+        using type = InheritanceList<OrderedType<
+          typelist::At<entries.values[I].source, Indexer>,
+          entries.values[I].order
+        >...>;
+      };
+
     public:
-    using type = typename RemoverType::type;
-    const static unsigned value = std::is_same<T, FT>::value ? FO : RemoverType::value;
-  };
+      using type = typename Build<std::make_index_sequence<entries.size>>::type;
+    };
 
-  
-  template <class T, unsigned O, class Previous, class List> struct InheritanceListPusher;
-  
-  template <class T, unsigned O, typename ... Previous> struct InheritanceListPusher <
-    T,
-    O,
-    InheritanceList<Previous...>,
-    InheritanceList<>
-  > {
-    using type = InheritanceList<Previous..., OrderedType<T, O>>;
-  };
-  
-  template <typename ... Args> struct InheritanceListMerger;
-  template <class A, class B, typename ... Rest> struct InheritanceListMerger<A,B,Rest...>{
-    using type = typename InheritanceListMerger<
-      typename InheritanceListMerger<A,B>::type,
-      Rest...
-    >::type;
-  };
-  template <class B> struct InheritanceListMerger<
-    InheritanceList<>,
-    B
-  > {
-    using type = B;
-  };
-  template <typename ... ARest, class FT, unsigned FO, class B> struct InheritanceListMerger<
-    InheritanceList<OrderedType<FT, FO>, ARest...>,
-    B
-  > {
-    using type = typename InheritanceListMerger<
-      InheritanceList<ARest...>,
-      typename B::template Push<FT, FO>
-    >::type;
+  }
+
+  /**
+   * Merges the InheritanceLists `Lists` by pushing all elements of a list into the next one.
+   */
+  template <typename ... Lists> struct InheritanceListMerger {
+    using type = typename inheritance_list::Merge<typename inheritance_list::Concat<Lists...>::type, Lists::size...>::type;
   };
-  
-  template <class T, unsigned O, typename ... Previous, class FT, unsigned FO, typename ... Rest> struct InheritanceListPusher <
-    T,
-    O,
-    InheritanceList<Previous ...>,
-    InheritanceList<OrderedType<FT, FO>, Rest ...>
-  > {
-    using type = typename std::conditional<
-      (O >= FO),
-      InheritanceList<Previous..., OrderedType<T, O>, OrderedType<FT, FO>, Rest...>,
-      typename InheritanceListPusher<
-        T,
-        O,
-        InheritanceList<Previous..., OrderedType<FT, FO>>,
-        InheritanceList<Rest...>
-      >::type
-    >::type;
+
+  /**
+   * Pushes `T` with order `O` into `List`, keeping the larger order if `T` is already contained.
+   */
+  template <class T, unsigned O, class List> struct InheritanceListPusher {
+    using type = typename InheritanceListMerger<InheritanceList<OrderedType<T, O>>, List>::type;
   };
-  
+
   template <class A> struct InheritanceListNextOrder;
   template <> struct InheritanceListNextOrder<InheritanceList<>> {
     static const unsigned value = 0;
@@ -116,19 +141,14 @@ namespace lars {
   };
 
   template <typename ... OrderedTypes> struct InheritanceList {
-  private:
-    template <class T> using Removed = InheritanceListRemover<T, InheritanceList<>, InheritanceList<OrderedTypes...>>;
-
-  public:
     const static size_t size = sizeof...(OrderedTypes);
     
     template <typename ... O> using Merge = typename InheritanceListMerger<InheritanceList, O...>::type;
     
     template <class T, unsigned O = InheritanceListNextOrder<InheritanceList>::value> using Push = typename InheritanceListPusher<
       T,
-      std::max(Removed<T>::value, O),
-      InheritanceList<>,
-      typename Removed<T>::type
+      O,
+      InheritanceList
     >::type;
     
     using Types = TypeList<typename OrderedTypes::type ...>;
@@ -0,0 +1,177 @@
+#pragma once
+
+#include <lars/any_function.h>
+
+#include <list>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace lars {
+
+  namespace memoize_detail {
+
+    template <class T> bool appendValue(const Any & value, const StaticTypeIndex & type, std::string & key) {
+      if (type != getStaticTypeIndex<T>()) { return false; }
+      auto & v = value.get<const T &>();
+      if constexpr (std::is_same<T, std::string>::value) {
+        auto size = v.size();
+        key.append(reinterpret_cast<const char *>(&size), sizeof(size));
+        key.append(v);
+      } else {
+        key.append(reinterpret_cast<const char *>(&v), sizeof(T));
+      }
+      return true;
+    }
+
+    template <typename ... Types> bool appendArgument(const Any & value, std::string & key, TypeList<Types...>) {
+      StaticTypeIndex type = value.type();
+      auto hash = type.hash();
+      key.append(reinterpret_cast<const char *>(&hash), sizeof(hash));
+      return (appendValue<Types>(value, type, key) || ...);
+    }
+
+    /**
+     * Types that can be used as arguments for memoized functions.
+     */
+    using KeyTypes = TypeList<
+      bool, char, int, long, long long, unsigned char, unsigned int, unsigned long, unsigned long long,
+      float, double, std::string
+    >;
+
+    /**
+     * Encodes the arguments in `key`.
+     * @return - `false`, if an argument is not of a supported type.
+     */
+    inline bool makeKey(const AnyArguments & args, std::string & key) {
+      for (auto & arg: args) {
+        if (!arg) { return false; }
+        if (!appendArgument(arg, key, KeyTypes())) { return false; }
+      }
+      return true;
+    }
+
+  }
+
+  /**
+   * An any function that caches the results of another function.
+   * Arguments are hashed using their type and value. Calls with arguments of types not
+   * contained in `memoize_detail::KeyTypes` are forwarded without caching.
+   * The least recently used result is removed when the capacity is exceeded.
+   */
+  class MemoizedAnyFunction: public SpecificAnyFunctionBase {
+  private:
+    using Entry = std::pair<std::string, AnyReference>;
+
+    AnyFunction function;
+    size_t capacity;
+    mutable std::mutex mutex;
+    mutable std::list<Entry> entries;
+    mutable std::unordered_map<std::string_view, std::list<Entry>::iterator> index;
+
+  public:
+    MemoizedAnyFunction(AnyFunction f, size_t c):function(std::move(f)),capacity(c){
+      if (!function) { throw UndefinedAnyFunctionException(); }
+    }
+
+    Any call(const AnyArguments & args) const override {
+      Any result;
+      callInto(args, result);
+      return result;
+    }
+
+    /**
+     * Stores a copy of the cached result in `result`, reusing its storage if possible.
+     * Results that cannot be copied are stored as a const reference to the cached value.
+     */
+    void callInto(const AnyArguments & args, Any & result) const override {
+      std::string key;
+      if (capacity == 0 || !memoize_detail::makeKey(args, key)) {
+        function.call(args, result);
+        return;
+      }
+      auto & specific = *function.getSpecific();
+
+      AnyReference cached;
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it != index.end()) {
+          entries.splice(entries.begin(), entries, it->second);
+          cached = it->second->second;
+        }
+      }
+      if (cached) {
+        if (!specific.copyResult(cached, result)) { result.setReference(cached); }
+        return;
+      }
+
+      function.call(args, result);
+      if (!specific.copyResult(result, cached)) {
+        cached.setConstReference(result);
+        result.setReference(cached);
+      }
+
+      std::lock_guard<std::mutex> lock(mutex);
+      if (index.find(key) == index.end()) {
+        entries.emplace_front(std::move(key), cached);
+        index.emplace(entries.front().first, entries.begin());
+        if (entries.size() > capacity) {
+          index.erase(entries.back().first);
+          entries.pop_back();
+        }
+      }
+    }
+
+    bool copyResult(const Any & value, Any & copy) const override {
+      return function.getSpecific()->copyResult(value, copy);
+    }
+
+    void callBatch(const AnyArguments & columns, Any & result, size_t threads) const override {
+      function.callBatch(columns, result, threads);
+    }
+
+    const AnyFunctionSignature & signature()const override{
+      return function.signature();
+    }
+
+    TypeIndex returnType()const override{
+      return function.returnType();
+    }
+
+    TypeIndex argumentType(size_t i)const override{
+      return function.argumentType(i);
+    }
+
+    size_t argumentCount()const override{
+      return function.argumentCount();
+    }
+
+    bool isVariadic()const override{
+      return function.isVariadic();
+    }
+
+    /**
+     * The number of cached results.
+     */
+    size_t size() const {
+      std::lock_guard<std::mutex> lock(mutex);
+      return entries.size();
+    }
+
+  };
+
+  /**
+   * Returns an AnyFunction that caches up to `capacity` results of `f`.
+   * Cached results are reused for calls with the same arguments, so `f` should be pure.
+   * Callers receive copies of the cached results, which can be modified as the results of `f`.
+   * Results that cannot be copied, such as results returned as `Any` or `std::shared_ptr`,
+   * are returned as const references to the cached value instead.
+   * The returned function is safe to call from multiple threads.
+   */
+  inline AnyFunction memoize(AnyFunction f, size_t capacity){
+    return AnyFunction::fromSpecific(std::make_shared<MemoizedAnyFunction>(std::move(f), capacity));
+  }
+
+}
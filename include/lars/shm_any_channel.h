@@ -0,0 +1,349 @@
+#pragma once
+
+#include <lars/any_serializer.h>
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lars {
+
+  /**
+   * Is raised when a shared memory channel cannot be created or opened, or when a value does
+   * not fit into a slot
+   */
+  class ShmAnyChannelException: public std::exception {
+  private:
+    std::string buffer;
+
+  public:
+    ShmAnyChannelException(std::string message):buffer(std::move(message)){ }
+
+    const char * what() const noexcept override {
+      return buffer.c_str();
+    }
+  };
+
+  namespace shm_any_channel_detail {
+
+    constexpr char magic[8] = {'L', 'A', 'N', 'Y', 'S', 'H', 'M', '\0'};
+    constexpr uint32_t version = 1;
+    constexpr size_t cacheLine = 64;
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared memory requires lock-free atomics");
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared memory requires lock-free atomics");
+
+    /**
+     * Placed at the start of the shared memory segment. The producer and consumer positions are
+     * kept on separate cache lines.
+     */
+    struct Header {
+      char magic[8];
+      uint32_t version;
+      uint32_t mode;
+      uint64_t slotCount;
+      uint64_t slotSize;
+      std::atomic<uint32_t> ready;
+      alignas(cacheLine) std::atomic<uint64_t> head;
+      alignas(cacheLine) std::atomic<uint64_t> tail;
+    };
+
+    /**
+     * Precedes the serialized entry in every slot. `sequence` implements the bounded queue of
+     * D. Vyukov: a slot at position `p` is writable if `sequence == p` and readable if
+     * `sequence == p + 1`.
+     */
+    struct SlotHeader {
+      std::atomic<uint64_t> sequence;
+      uint64_t size;
+    };
+
+    constexpr size_t roundUp(size_t size, size_t alignment) {
+      return (size + alignment - 1) / alignment * alignment;
+    }
+
+    inline std::string systemError(const std::string &message) {
+      return message + ": " + std::strerror(errno);
+    }
+
+    /**
+     * Closes a file descriptor when leaving scope.
+     */
+    struct FileDescriptor {
+      int fd;
+      ~FileDescriptor() { if (fd >= 0) { ::close(fd); } }
+    };
+
+  }
+
+  /**
+   * A bounded message queue of Any values in POSIX shared memory, for exchanging values between
+   * processes on the same host. Values are serialized by an `AnySerializer` into fixed-size
+   * slots. Numeric values, and strings if enabled by `AnySerializer::setStringViews`, are
+   * received as views into the slot, so their payload is copied only once by the sender.
+   * Both processes must use serializers supporting the same types.
+   *
+   * In `Mode::spsc`, at most one thread in all processes may send and at most one may receive
+   * at a time. `Mode::mpmc` allows any number of concurrent senders and receivers at the cost
+   * of an atomic compare-and-swap per operation.
+   */
+  class ShmAnyChannel {
+  public:
+    enum class Mode: uint32_t {
+      spsc, mpmc
+    };
+
+  private:
+    std::string name;
+    void * memory = nullptr;
+    size_t mappedSize = 0;
+    bool owner = false;
+    AnySerializer serializer;
+
+    /**
+     * Copied from the header when creating or opening the channel, so that later operations do
+     * not depend on values another process could modify.
+     */
+    Mode channelMode = Mode::spsc;
+    size_t slots = 0;
+    size_t slotBytes = 0;
+    size_t stride = 0;
+
+    ShmAnyChannel(std::string n, AnySerializer s):name(std::move(n)),serializer(std::move(s)){ }
+
+    shm_any_channel_detail::Header & header() const {
+      return *static_cast<shm_any_channel_detail::Header *>(memory);
+    }
+
+    static size_t slotsOffset() {
+      return shm_any_channel_detail::roundUp(sizeof(shm_any_channel_detail::Header), shm_any_channel_detail::cacheLine);
+    }
+
+    static size_t slotStride(size_t slotSize) {
+      return shm_any_channel_detail::roundUp(sizeof(shm_any_channel_detail::SlotHeader) + slotSize, shm_any_channel_detail::cacheLine);
+    }
+
+    shm_any_channel_detail::SlotHeader & slot(uint64_t position) const {
+      auto offset = slotsOffset() + (position & (slots - 1)) * stride;
+      return *reinterpret_cast<shm_any_channel_detail::SlotHeader *>(static_cast<char *>(memory) + offset);
+    }
+
+    static char * data(shm_any_channel_detail::SlotHeader &slot) {
+      return reinterpret_cast<char *>(&slot) + sizeof(shm_any_channel_detail::SlotHeader);
+    }
+
+    void setLayout(Mode mode, size_t slotCount, size_t slotSize) {
+      channelMode = mode;
+      slots = slotCount;
+      slotBytes = slotSize;
+      stride = slotStride(slotSize);
+    }
+
+    void map(int fd, size_t size) {
+      memory = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if (memory == MAP_FAILED) {
+        memory = nullptr;
+        throw ShmAnyChannelException(shm_any_channel_detail::systemError("cannot map shared memory " + name));
+      }
+      mappedSize = size;
+    }
+
+    /**
+     * Claims the next position of `counter` for which the slot sequence equals the position
+     * plus `offset`. Returns `false` if no such slot is available.
+     */
+    bool claim(std::atomic<uint64_t> &counter, uint64_t offset, uint64_t &position) const {
+      position = counter.load(std::memory_order_relaxed);
+      while (true) {
+        auto sequence = slot(position).sequence.load(std::memory_order_acquire);
+        auto difference = int64_t(sequence - (position + offset));
+        if (difference == 0) {
+          if (channelMode == Mode::spsc) {
+            counter.store(position + 1, std::memory_order_relaxed);
+            return true;
+          }
+          if (counter.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) { return true; }
+        } else if (difference < 0) {
+          return false;
+        } else {
+          position = counter.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    /**
+     * Releases a received slot for writing, even if the receiver raised an exception.
+     */
+    struct Release {
+      const ShmAnyChannel &channel;
+      uint64_t position;
+      ~Release() {
+        channel.slot(position).sequence.store(position + channel.slots, std::memory_order_release);
+      }
+    };
+
+  public:
+
+    /**
+     * Creates a new shared memory object `name` (see `shm_open`) containing `slotCount` slots,
+     * each holding a serialized value of up to `slotSize` bytes, including the 16 byte entry
+     * header. `slotCount` must be a power of two. The name is removed when the channel is
+     * destroyed; processes that opened the channel keep their mapping.
+     */
+    static ShmAnyChannel create(const std::string &name, size_t slotCount, size_t slotSize, Mode mode = Mode::spsc, AnySerializer serializer = AnySerializer()) {
+      using namespace shm_any_channel_detail;
+      if (slotCount == 0 || (slotCount & (slotCount - 1)) != 0) {
+        throw ShmAnyChannelException("slot count must be a power of two");
+      }
+      ShmAnyChannel channel(name, std::move(serializer));
+      FileDescriptor file{::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600)};
+      if (file.fd < 0) { throw ShmAnyChannelException(systemError("cannot create shared memory " + name)); }
+      channel.owner = true;
+      auto size = slotsOffset() + slotCount * slotStride(slotSize);
+      if (::ftruncate(file.fd, off_t(size)) != 0) {
+        throw ShmAnyChannelException(systemError("cannot resize shared memory " + name));
+      }
+      channel.map(file.fd, size);
+      channel.setLayout(mode, slotCount, slotSize);
+
+      auto header = new (channel.memory) Header();
+      std::memcpy(header->magic, magic, sizeof(magic));
+      header->version = version;
+      header->mode = uint32_t(mode);
+      header->slotCount = slotCount;
+      header->slotSize = slotSize;
+      header->head.store(0, std::memory_order_relaxed);
+      header->tail.store(0, std::memory_order_relaxed);
+      for (uint64_t i = 0; i < slotCount; ++i) {
+        auto &slot = *new (&channel.slot(i)) SlotHeader();
+        slot.sequence.store(i, std::memory_order_relaxed);
+        slot.size = 0;
+      }
+      header->ready.store(1, std::memory_order_release);
+      return channel;
+    }
+
+    /**
+     * Opens a channel created by another process.
+     */
+    static ShmAnyChannel open(const std::string &name, AnySerializer serializer = AnySerializer()) {
+      using namespace shm_any_channel_detail;
+      ShmAnyChannel channel(name, std::move(serializer));
+      FileDescriptor file{::shm_open(name.c_str(), O_RDWR, 0600)};
+      if (file.fd < 0) { throw ShmAnyChannelException(systemError("cannot open shared memory " + name)); }
+      struct stat status;
+      if (::fstat(file.fd, &status) != 0) {
+        throw ShmAnyChannelException(systemError("cannot open shared memory " + name));
+      }
+      if (size_t(status.st_size) < slotsOffset()) { throw ShmAnyChannelException("invalid shared memory " + name); }
+      channel.map(file.fd, size_t(status.st_size));
+      auto &header = channel.header();
+      if (header.ready.load(std::memory_order_acquire) != 1 || std::memcmp(header.magic, magic, sizeof(magic)) != 0) {
+        throw ShmAnyChannelException("invalid or uninitialized shared memory " + name);
+      }
+      if (header.version != version) { throw ShmAnyChannelException("unsupported channel version"); }
+      auto mode = header.mode;
+      auto slotCount = header.slotCount;
+      auto slotSize = header.slotSize;
+      if (mode > uint32_t(Mode::mpmc) || slotCount == 0 || (slotCount & (slotCount - 1)) != 0 || slotCount > channel.mappedSize || slotSize > channel.mappedSize || slotsOffset() + slotCount * slotStride(slotSize) > channel.mappedSize) {
+        throw ShmAnyChannelException("invalid shared memory " + name);
+      }
+      channel.setLayout(Mode(mode), slotCount, slotSize);
+      return channel;
+    }
+
+    ShmAnyChannel(ShmAnyChannel &&other):
+      name(std::move(other.name)),
+      memory(std::exchange(other.memory, nullptr)),
+      mappedSize(std::exchange(other.mappedSize, 0)),
+      owner(std::exchange(other.owner, false)),
+      serializer(std::move(other.serializer)),
+      channelMode(other.channelMode),
+      slots(other.slots),
+      slotBytes(other.slotBytes),
+      stride(other.stride){
+    }
+
+    ShmAnyChannel(const ShmAnyChannel &) = delete;
+    ShmAnyChannel &operator=(const ShmAnyChannel &) = delete;
+    ShmAnyChannel &operator=(ShmAnyChannel &&) = delete;
+
+    ~ShmAnyChannel() {
+      if (memory) { ::munmap(memory, mappedSize); }
+      if (owner) { ::shm_unlink(name.c_str()); }
+    }
+
+    Mode mode() const { return channelMode; }
+    size_t slotCount() const { return slots; }
+    size_t slotSize() const { return slotBytes; }
+
+    /**
+     * Sends `value` if a slot is free. Returns `false` if the channel is full.
+     * Raises a `ShmAnyChannelException` if the serialized value exceeds the slot size.
+     */
+    bool trySend(const Any &value) {
+      static thread_local std::string buffer;
+      buffer.clear();
+      serializer.write(value, buffer);
+      if (buffer.size() > slotBytes) {
+        throw ShmAnyChannelException("value of " + std::to_string(buffer.size()) + " bytes exceeds slot size");
+      }
+      uint64_t position;
+      if (!claim(header().head, 0, position)) { return false; }
+      auto &target = slot(position);
+      std::memcpy(data(target), buffer.data(), buffer.size());
+      target.size = buffer.size();
+      target.sequence.store(position + 1, std::memory_order_release);
+      return true;
+    }
+
+    /**
+     * Sends `value`, yielding while the channel is full.
+     */
+    void send(const Any &value) {
+      while (!trySend(value)) { std::this_thread::yield(); }
+    }
+
+    /**
+     * Calls `f(value)` with the next value if one is available. The value may reference the
+     * slot, which is released for new values when `f` returns.
+     * Returns `false` if the channel is empty. Raises a `ShmAnyChannelException` and releases
+     * the slot if the entry size stored in the slot exceeds the slot size.
+     */
+    template <class F> bool tryReceive(F && f) {
+      uint64_t position;
+      if (!claim(header().tail, 1, position)) { return false; }
+      Release release{*this, position};
+      auto &source = slot(position);
+      // the size is written by another process, so it is read once and validated
+      auto size = source.size;
+      if (size > slotBytes) {
+        throw ShmAnyChannelException("entry of " + std::to_string(size) + " bytes exceeds slot size");
+      }
+      size_t offset = 0;
+      f(serializer.read(std::string_view(data(source), size), offset));
+      return true;
+    }
+
+    /**
+     * Calls `f(value)` with the next value, yielding while the channel is empty.
+     */
+    template <class F> void receive(F && f) {
+      while (!tryReceive(f)) { std::this_thread::yield(); }
+    }
+
+  };
+
+}
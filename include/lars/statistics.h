@@ -0,0 +1,313 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <lars/type_index.h>
+
+namespace lars {
+
+  /**
+   * `true`, if the library is compiled with `LARS_VISITOR_STATS` defined. Otherwise all
+   * statistics hooks are discarded at compile time and snapshots are empty.
+   */
+#ifdef LARS_VISITOR_STATS
+  constexpr bool statisticsEnabled = true;
+#else
+  constexpr bool statisticsEnabled = false;
+#endif
+
+  /**
+   * The dispatch counters of a visitable type visited by a visitor type.
+   */
+  struct DispatchCounters {
+    TypeIndex visitableType;
+    TypeIndex visitorType;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    /**
+     * The total number of candidate types tested before a match or miss.
+     */
+    uint64_t probes = 0;
+    uint64_t maxProbes = 0;
+
+    DispatchCounters(TypeIndex visitable, TypeIndex visitor):visitableType(visitable),visitorType(visitor){ }
+
+    double averageProbes() const {
+      auto dispatches = hits + misses;
+      return dispatches > 0 ? double(probes) / double(dispatches) : 0;
+    }
+  };
+
+  /**
+   * The merged counters of all threads.
+   */
+  struct Statistics {
+    /**
+     * Ordered by the number of dispatches, most frequent first.
+     */
+    std::vector<DispatchCounters> dispatches;
+    uint64_t invalidVisitorExceptions = 0;
+    uint64_t anyAllocations = 0;
+    uint64_t anyFunctionCalls = 0;
+
+    /**
+     * Writes a human readable summary to `stream`.
+     */
+    void dump(std::ostream &stream) const {
+      stream << "dispatches:\n";
+      for (auto &d: dispatches) {
+        stream << "  " << getPrettyTypeName(d.visitableType) << " by " << getPrettyTypeName(d.visitorType);
+        stream << ": " << d.hits << " hits, " << d.misses << " misses, ";
+        stream << d.averageProbes() << " average probes, " << d.maxProbes << " max probes\n";
+      }
+      stream << "invalid visitor exceptions: " << invalidVisitorExceptions << '\n';
+      stream << "Any allocations: " << anyAllocations << '\n';
+      stream << "AnyFunction calls: " << anyFunctionCalls << '\n';
+    }
+  };
+
+  namespace statistics_detail {
+
+    using Counter = std::atomic<uint64_t>;
+
+    /**
+     * Counters are only written by their owning thread, so a relaxed load and store suffices
+     * and avoids a locked read-modify-write on the hot path.
+     */
+    inline void add(Counter &counter, uint64_t value = 1) {
+      counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    inline uint64_t read(const Counter &counter) {
+      return counter.load(std::memory_order_relaxed);
+    }
+
+    struct DispatchEntry {
+      TypeIndex visitableType;
+      TypeIndex visitorType;
+      Counter hits{0};
+      Counter misses{0};
+      Counter probes{0};
+      Counter maxProbes{0};
+
+      DispatchEntry(TypeIndex visitable, TypeIndex visitor):visitableType(visitable),visitorType(visitor){ }
+    };
+
+    using Key = std::pair<size_t, size_t>;
+
+    struct KeyHash {
+      size_t operator()(const Key &key) const {
+        return key.first ^ (key.second + 0x9E3779B97F4A7C15ull + (key.first << 6) + (key.first >> 2));
+      }
+    };
+
+    /**
+     * Accumulates merged counters.
+     */
+    class Accumulator {
+    private:
+      std::unordered_map<Key, DispatchCounters, KeyHash> dispatches;
+
+    public:
+      Statistics totals;
+
+      void addDispatch(const DispatchEntry &entry) {
+        auto key = std::make_pair(entry.visitableType.hash(), entry.visitorType.hash());
+        auto it = dispatches.find(key);
+        if (it == dispatches.end()) {
+          it = dispatches.emplace(key, DispatchCounters(entry.visitableType, entry.visitorType)).first;
+        }
+        auto &counters = it->second;
+        counters.hits += read(entry.hits);
+        counters.misses += read(entry.misses);
+        counters.probes += read(entry.probes);
+        counters.maxProbes = std::max(counters.maxProbes, read(entry.maxProbes));
+      }
+
+      Statistics result() const {
+        auto statistics = totals;
+        for (auto &d: dispatches) {
+          if (d.second.hits + d.second.misses > 0) { statistics.dispatches.push_back(d.second); }
+        }
+        std::sort(statistics.dispatches.begin(), statistics.dispatches.end(), [](auto &a, auto &b){
+          return a.hits + a.misses > b.hits + b.misses;
+        });
+        return statistics;
+      }
+    };
+
+    class Registry;
+    Registry &getRegistry();
+
+    /**
+     * The counters of a single thread. Registered with the registry for its lifetime and
+     * merged into the retired counters when the thread exits.
+     */
+    class ThreadCounters {
+    private:
+      /**
+       * Guards insertions into `dispatches` against concurrent snapshots. Lookups by the
+       * owning thread do not lock.
+       */
+      mutable std::mutex mutex;
+      std::unordered_map<Key, std::unique_ptr<DispatchEntry>, KeyHash> dispatches;
+
+      /**
+       * A direct-mapped cache of recently used entries in front of `dispatches`.
+       */
+      struct CacheSlot {
+        Key key{0, 0};
+        DispatchEntry * entry = nullptr;
+      };
+      static constexpr size_t cacheSize = 64;
+      std::array<CacheSlot, cacheSize> cache;
+
+    public:
+      Counter invalidVisitorExceptions{0};
+      Counter anyAllocations{0};
+      Counter anyFunctionCalls{0};
+
+      ThreadCounters();
+      ~ThreadCounters();
+
+      DispatchEntry & dispatch(const TypeIndex &visitable, const TypeIndex &visitor) {
+        auto key = std::make_pair(visitable.hash(), visitor.hash());
+        auto &slot = cache[KeyHash()(key) % cacheSize];
+        if (slot.entry && slot.key == key) { return *slot.entry; }
+        auto it = dispatches.find(key);
+        if (it == dispatches.end()) {
+          std::lock_guard<std::mutex> lock(mutex);
+          it = dispatches.emplace(key, std::make_unique<DispatchEntry>(visitable, visitor)).first;
+        }
+        slot.key = key;
+        slot.entry = it->second.get();
+        return *slot.entry;
+      }
+
+      void mergeInto(Accumulator &accumulator) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &entry: dispatches) { accumulator.addDispatch(*entry.second); }
+        accumulator.totals.invalidVisitorExceptions += read(invalidVisitorExceptions);
+        accumulator.totals.anyAllocations += read(anyAllocations);
+        accumulator.totals.anyFunctionCalls += read(anyFunctionCalls);
+      }
+
+      void reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto &entry: dispatches) {
+          for (auto counter: { &entry.second->hits, &entry.second->misses, &entry.second->probes, &entry.second->maxProbes }) {
+            counter->store(0, std::memory_order_relaxed);
+          }
+        }
+        for (auto counter: { &invalidVisitorExceptions, &anyAllocations, &anyFunctionCalls }) {
+          counter->store(0, std::memory_order_relaxed);
+        }
+      }
+    };
+
+    class Registry {
+    private:
+      std::mutex mutex;
+      std::vector<ThreadCounters *> threads;
+      Accumulator retired;
+
+    public:
+      void add(ThreadCounters *counters) {
+        std::lock_guard<std::mutex> lock(mutex);
+        threads.push_back(counters);
+      }
+
+      void remove(ThreadCounters *counters) {
+        std::lock_guard<std::mutex> lock(mutex);
+        counters->mergeInto(retired);
+        threads.erase(std::find(threads.begin(), threads.end(), counters));
+      }
+
+      Statistics snapshot() {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto accumulator = retired;
+        for (auto thread: threads) { thread->mergeInto(accumulator); }
+        return accumulator.result();
+      }
+
+      void reset() {
+        std::lock_guard<std::mutex> lock(mutex);
+        retired = Accumulator();
+        for (auto thread: threads) { thread->reset(); }
+      }
+    };
+
+    inline Registry &getRegistry() {
+      static Registry registry;
+      return registry;
+    }
+
+    inline ThreadCounters::ThreadCounters() {
+      getRegistry().add(this);
+    }
+
+    inline ThreadCounters::~ThreadCounters() {
+      getRegistry().remove(this);
+    }
+
+    inline ThreadCounters &getThreadCounters() {
+      static thread_local ThreadCounters counters;
+      return counters;
+    }
+
+    /**
+     * Records a dispatch of `visitable` by `visitor` after testing `probes` candidate types.
+     */
+    inline void recordDispatch(const TypeIndex &visitable, const TypeIndex &visitor, size_t probes, bool hit) {
+      auto &entry = getThreadCounters().dispatch(visitable, visitor);
+      add(hit ? entry.hits : entry.misses);
+      add(entry.probes, probes);
+      if (probes > read(entry.maxProbes)) { entry.maxProbes.store(probes, std::memory_order_relaxed); }
+    }
+
+    inline void recordInvalidVisitorException() {
+      add(getThreadCounters().invalidVisitorExceptions);
+    }
+
+    inline void recordAnyAllocation() {
+      add(getThreadCounters().anyAllocations);
+    }
+
+    inline void recordAnyFunctionCall() {
+      add(getThreadCounters().anyFunctionCalls);
+    }
+
+  }
+
+  /**
+   * Returns the merged counters of all threads, including threads that have exited.
+   * Counters of running threads are read without stopping them, so the snapshot may miss
+   * events recorded concurrently.
+   */
+  inline Statistics getStatistics() {
+    if constexpr (statisticsEnabled) {
+      return statistics_detail::getRegistry().snapshot();
+    } else {
+      return Statistics();
+    }
+  }
+
+  /**
+   * Resets the counters of all threads. Events recorded concurrently may be retained.
+   */
+  inline void resetStatistics() {
+    if constexpr (statisticsEnabled) {
+      statistics_detail::getRegistry().reset();
+    }
+  }
+
+}
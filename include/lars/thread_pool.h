@@ -0,0 +1,328 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace lars {
+
+  /**
+   * A pool with a fixed number of worker threads.
+   * Every worker owns a task queue. Tasks pushed from a worker are added to its own queue,
+   * other tasks are distributed round-robin. Idle workers steal tasks from other queues.
+   * At most `capacity` tasks are queued at a time. Further tasks are handled according to
+   * the pool's `Overflow` policy.
+   */
+  class ThreadPool {
+  public:
+    using Task = std::function<void()>;
+
+    /**
+     * Defines how `push` handles tasks while the pool is at capacity.
+     */
+    enum class Overflow {
+      /**
+       * The task is run in the calling thread.
+       */
+      runInCaller,
+      /**
+       * The calling thread blocks until a queued task has been taken. Tasks pushed from
+       * workers of the pool are run in the calling worker instead, as all workers could
+       * block otherwise.
+       */
+      block
+    };
+
+    static constexpr size_t defaultCapacity = 1 << 16;
+
+  private:
+    /**
+     * A thread waiting in `helpUntil` to be notified through its condition.
+     */
+    struct Helper {
+      std::mutex * mutex;
+      std::condition_variable * condition;
+    };
+
+    struct Queue {
+      std::mutex mutex;
+      std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::condition_variable space;
+    std::atomic<size_t> pending{0};
+    std::atomic<size_t> nextQueue{0};
+    std::atomic<size_t> blocked{0};
+    std::vector<Helper> helpers;
+    std::atomic<size_t> helperCount{0};
+    size_t capacity;
+    Overflow overflow;
+    bool stopping = false;
+
+    struct CurrentWorker {
+      ThreadPool * pool = nullptr;
+      size_t index = 0;
+    };
+
+    static CurrentWorker & currentWorker() {
+      static thread_local CurrentWorker current;
+      return current;
+    }
+
+    bool tryPop(size_t index, Task & task, bool own) {
+      {
+        auto & queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) { return false; }
+        if (own) {
+          task = std::move(queue.tasks.back());
+          queue.tasks.pop_back();
+        } else {
+          task = std::move(queue.tasks.front());
+          queue.tasks.pop_front();
+        }
+        --pending;
+      }
+      if (blocked > 0) {
+        std::lock_guard<std::mutex> poolLock(mutex);
+        space.notify_one();
+      }
+      return true;
+    }
+
+    /**
+     * Wakes the threads waiting in `helpUntil` after a task has been queued.
+     */
+    void notifyHelpers() {
+      if (helperCount == 0) { return; }
+      std::lock_guard<std::mutex> lock(mutex);
+      for (auto & helper: helpers) {
+        std::lock_guard<std::mutex> helperLock(*helper.mutex);
+        helper.condition->notify_all();
+      }
+    }
+
+    bool tryTake(size_t first, Task & task) {
+      for (size_t i = 0; i < queues.size(); ++i) {
+        auto index = (first + i) % queues.size();
+        if (tryPop(index, task, i == 0 && currentWorker().pool == this)) { return true; }
+      }
+      return false;
+    }
+
+    void work(size_t index) {
+      currentWorker() = CurrentWorker{this, index};
+      Task task;
+      while (true) {
+        if (tryTake(index, task)) {
+          task();
+          task = nullptr;
+          continue;
+        }
+        std::unique_lock<std::mutex> lock(mutex);
+        condition.wait(lock, [&](){ return stopping || pending > 0; });
+        if (stopping && pending == 0) { break; }
+      }
+      currentWorker() = CurrentWorker();
+    }
+
+  public:
+
+    /**
+     * Creates a pool with `threadCount` workers and at most `capacity` queued tasks.
+     */
+    explicit ThreadPool(
+      size_t threadCount = std::thread::hardware_concurrency(),
+      size_t _capacity = defaultCapacity,
+      Overflow _overflow = Overflow::runInCaller
+    ):capacity(std::max<size_t>(_capacity, 1)),overflow(_overflow) {
+      threadCount = std::max<size_t>(threadCount, 1);
+      for (size_t i = 0; i < threadCount; ++i) {
+        queues.emplace_back(std::make_unique<Queue>());
+      }
+      for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back([this, i](){ work(i); });
+      }
+    }
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * Finishes all queued tasks and joins the worker threads.
+     */
+    ~ThreadPool() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+      }
+      condition.notify_all();
+      for (auto & worker: workers) { worker.join(); }
+    }
+
+    /**
+     * The pool used by default for asynchronous calls.
+     */
+    static ThreadPool & shared() {
+      static ThreadPool pool;
+      return pool;
+    }
+
+    /**
+     * The number of worker threads.
+     */
+    size_t size() const {
+      return workers.size();
+    }
+
+    /**
+     * `true`, if called from a worker thread of this pool.
+     */
+    bool isWorkerThread() const {
+      return currentWorker().pool == this;
+    }
+
+    /**
+     * The pool of the calling worker thread, or `nullptr` if not called from a worker.
+     */
+    static ThreadPool * current() {
+      return currentWorker().pool;
+    }
+
+    /**
+     * The maximum number of queued tasks.
+     */
+    size_t getCapacity() const {
+      return capacity;
+    }
+
+    /**
+     * Adds a task to the pool. If the pool is at capacity, the task is handled according to
+     * the overflow policy.
+     */
+    void push(Task task) {
+      auto & current = currentWorker();
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (pending >= capacity) {
+          if (overflow == Overflow::block && current.pool != this) {
+            ++blocked;
+            space.wait(lock, [&](){ return pending < capacity; });
+            --blocked;
+          } else {
+            lock.unlock();
+            task();
+            return;
+          }
+        }
+        ++pending;
+      }
+      auto index = current.pool == this ? current.index : nextQueue++ % queues.size();
+      {
+        auto & queue = *queues[index];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.emplace_back(std::move(task));
+      }
+      condition.notify_one();
+      notifyHelpers();
+    }
+
+    /**
+     * Runs a single queued task in the calling thread.
+     * Used to keep threads busy that wait for results from the pool.
+     * @return - `true`, if a task has been run.
+     */
+    bool tryRunTask() {
+      auto & current = currentWorker();
+      Task task;
+      if (tryTake(current.pool == this ? current.index : 0, task)) {
+        task();
+        return true;
+      }
+      return false;
+    }
+
+    /**
+     * Runs queued tasks in the calling thread until `ready()` returns `true`. `lock` must hold
+     * `mutex`, which is released while running tasks. If no task is queued, waits for
+     * `condition`, which is notified by `push` and must also be notified when `ready()`
+     * changes. Used to wait for results in worker threads without blocking the pool.
+     */
+    template <class Ready> void helpUntil(std::unique_lock<std::mutex> & lock, std::condition_variable & condition, const Ready & ready) {
+      if (ready()) { return; }
+      lock.unlock();
+      {
+        std::lock_guard<std::mutex> poolLock(mutex);
+        helpers.push_back(Helper{lock.mutex(), &condition});
+        ++helperCount;
+      }
+      lock.lock();
+      while (!ready()) {
+        lock.unlock();
+        auto ranTask = tryRunTask();
+        lock.lock();
+        if (!ranTask) { condition.wait(lock, [&](){ return ready() || pending > 0; }); }
+      }
+      lock.unlock();
+      {
+        std::lock_guard<std::mutex> poolLock(mutex);
+        helpers.erase(std::find_if(helpers.begin(), helpers.end(), [&](auto & helper){ return helper.condition == &condition; }));
+        --helperCount;
+      }
+      lock.lock();
+    }
+
+    /**
+     * Calls `f(i)` for every `i` in `[0, count)` using the worker threads and the calling thread.
+     * Returns after all calls have finished. The first exception raised is rethrown.
+     */
+    template <class F> void forEach(size_t count, const F &f) {
+      if (count == 0) { return; }
+
+      struct State {
+        std::atomic<size_t> next{0};
+        std::atomic<size_t> finished{0};
+        std::mutex mutex;
+        std::condition_variable condition;
+        std::exception_ptr error;
+      };
+
+      auto state = std::make_shared<State>();
+      auto run = [state, count, &f](){
+        for (auto i = state->next++; i < count; i = state->next++) {
+          try {
+            f(i);
+          } catch (...) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            if (!state->error) { state->error = std::current_exception(); }
+          }
+          if (++state->finished == count) {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->condition.notify_all();
+          }
+        }
+      };
+
+      auto helpers = std::min(count, size() + 1) - 1;
+      for (size_t i = 0; i < helpers; ++i) { push(run); }
+      run();
+
+      std::unique_lock<std::mutex> lock(state->mutex);
+      state->condition.wait(lock, [&](){ return state->finished == count; });
+      if (state->error) { std::rethrow_exception(state->error); }
+    }
+
+  };
+
+}
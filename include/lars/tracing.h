@@ -0,0 +1,363 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <lars/any_function_signature.h>
+#include <lars/type_index.h>
+
+#ifndef LARS_VISITOR_TRACE_BUFFER_SIZE
+#define LARS_VISITOR_TRACE_BUFFER_SIZE 4096
+#endif
+
+namespace lars {
+
+  /**
+   * `true`, if the library is compiled with `LARS_VISITOR_TRACING` defined. Otherwise the
+   * tracing hooks are removed at compile time.
+   */
+#ifdef LARS_VISITOR_TRACING
+  constexpr bool tracingEnabled = true;
+#else
+  constexpr bool tracingEnabled = false;
+#endif
+
+  /**
+   * Receives the begin and end of visits and any function calls. Hooks are called from the
+   * thread performing the visit or call and must be thread-safe.
+   */
+  class TraceHook {
+  public:
+    virtual void beginVisit(const TypeIndex &visitable, const TypeIndex &visitor) = 0;
+    virtual void endVisit(const TypeIndex &visitable, const TypeIndex &visitor) = 0;
+    virtual void beginCall(const AnyFunctionSignature &signature) = 0;
+    virtual void endCall(const AnyFunctionSignature &signature) = 0;
+    virtual ~TraceHook(){}
+  };
+
+  enum class TraceEventKind: uint8_t {
+    beginVisit, endVisit, beginCall, endCall
+  };
+
+  /**
+   * An event recorded by the `TraceBuffer`.
+   * Note: for composed or bound any functions, `signature.argumentTypes` refers to storage
+   * of the function and is only valid while the function exists.
+   */
+  struct TraceEvent {
+    TraceEventKind kind = TraceEventKind::beginVisit;
+    /**
+     * Nanoseconds of `std::chrono::steady_clock`.
+     */
+    uint64_t time = 0;
+    TypeIndex visitableType = getTypeIndex<void>();
+    TypeIndex visitorType = getTypeIndex<void>();
+    AnyFunctionSignature signature{getStaticTypeIndex<void>(), nullptr, 0, false};
+  };
+
+  namespace tracing_detail {
+
+    inline uint64_t now() {
+      return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    /**
+     * A lock-free single producer, single consumer ring of trace events. Events are dropped
+     * if the ring is full.
+     */
+    class Ring {
+    private:
+      static constexpr size_t capacity = LARS_VISITOR_TRACE_BUFFER_SIZE;
+      static_assert((capacity & (capacity - 1)) == 0, "LARS_VISITOR_TRACE_BUFFER_SIZE must be a power of two");
+
+      std::vector<TraceEvent> events;
+      std::atomic<size_t> head{0};
+      std::atomic<size_t> tail{0};
+      std::atomic<uint64_t> droppedCount{0};
+
+    public:
+      const size_t thread;
+      std::atomic<bool> finished{false};
+
+      explicit Ring(size_t t):events(capacity),thread(t){ }
+
+      /**
+       * Called by the producing thread only.
+       */
+      void push(const TraceEvent &event) {
+        auto h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == capacity) {
+          droppedCount.store(droppedCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+          return;
+        }
+        events[h & (capacity - 1)] = event;
+        head.store(h + 1, std::memory_order_release);
+      }
+
+      /**
+       * Called by the consumer only.
+       */
+      template <class F> size_t drain(const F &f) {
+        auto t = tail.load(std::memory_order_relaxed);
+        auto h = head.load(std::memory_order_acquire);
+        for (auto i = t; i != h; ++i) { f(thread, events[i & (capacity - 1)]); }
+        tail.store(h, std::memory_order_release);
+        return h - t;
+      }
+
+      uint64_t dropped() const {
+        return droppedCount.load(std::memory_order_relaxed);
+      }
+    };
+
+  }
+
+  /**
+   * The default trace hook. Events are written to lock-free per-thread rings of
+   * `LARS_VISITOR_TRACE_BUFFER_SIZE` events, which are drained by a single consumer,
+   * usually a `TraceExporter`. Events recorded while a ring is full are dropped.
+   */
+  class TraceBuffer final: public TraceHook {
+  private:
+    std::mutex mutex;
+    std::vector<std::shared_ptr<tracing_detail::Ring>> rings;
+    size_t nextThread = 0;
+    uint64_t droppedByFinished = 0;
+
+    /**
+     * Owns the ring of the current thread and marks it as finished on thread exit, so that
+     * remaining events can still be drained.
+     */
+    struct ThreadRing {
+      std::shared_ptr<tracing_detail::Ring> ring;
+      ~ThreadRing() { if (ring) { ring->finished.store(true, std::memory_order_release); } }
+    };
+
+    tracing_detail::Ring & getRing() {
+      static thread_local ThreadRing current;
+      if (!current.ring) {
+        std::lock_guard<std::mutex> lock(mutex);
+        current.ring = std::make_shared<tracing_detail::Ring>(nextThread++);
+        rings.push_back(current.ring);
+      }
+      return *current.ring;
+    }
+
+    void push(TraceEventKind kind, const TypeIndex &visitable, const TypeIndex &visitor) {
+      TraceEvent event;
+      event.kind = kind;
+      event.time = tracing_detail::now();
+      event.visitableType = visitable;
+      event.visitorType = visitor;
+      getRing().push(event);
+    }
+
+    void push(TraceEventKind kind, const AnyFunctionSignature &signature) {
+      TraceEvent event;
+      event.kind = kind;
+      event.time = tracing_detail::now();
+      event.signature = signature;
+      getRing().push(event);
+    }
+
+    TraceBuffer() = default;
+
+  public:
+
+    static TraceBuffer & shared() {
+      static TraceBuffer buffer;
+      return buffer;
+    }
+
+    void beginVisit(const TypeIndex &visitable, const TypeIndex &visitor) override {
+      push(TraceEventKind::beginVisit, visitable, visitor);
+    }
+
+    void endVisit(const TypeIndex &visitable, const TypeIndex &visitor) override {
+      push(TraceEventKind::endVisit, visitable, visitor);
+    }
+
+    void beginCall(const AnyFunctionSignature &signature) override {
+      push(TraceEventKind::beginCall, signature);
+    }
+
+    void endCall(const AnyFunctionSignature &signature) override {
+      push(TraceEventKind::endCall, signature);
+    }
+
+    /**
+     * Calls `f(thread, event)` for all recorded events, in order per thread, and removes them
+     * from the buffer. Threads are numbered in order of their first event.
+     * @return - the number of drained events.
+     */
+    size_t drain(const std::function<void(size_t thread, const TraceEvent &event)> &f) {
+      std::lock_guard<std::mutex> lock(mutex);
+      size_t count = 0;
+      rings.erase(std::remove_if(rings.begin(), rings.end(), [&](auto &ring){
+        // a finished ring receives no further events, so it is empty after draining
+        auto finished = ring->finished.load(std::memory_order_acquire);
+        count += ring->drain(f);
+        if (finished) { droppedByFinished += ring->dropped(); }
+        return finished;
+      }), rings.end());
+      return count;
+    }
+
+    /**
+     * The number of events dropped as the ring of their thread was full.
+     */
+    uint64_t dropped() {
+      std::lock_guard<std::mutex> lock(mutex);
+      auto result = droppedByFinished;
+      for (auto &ring: rings) { result += ring->dropped(); }
+      return result;
+    }
+
+  };
+
+  namespace tracing_detail {
+
+    inline std::atomic<TraceHook *> & getHookStorage() {
+      static std::atomic<TraceHook *> hook{&TraceBuffer::shared()};
+      return hook;
+    }
+
+  }
+
+  /**
+   * Installs the trace hook. `nullptr` disables tracing at runtime. The default hook is
+   * `TraceBuffer::shared()`. The hook must remain valid until it is replaced.
+   */
+  inline void setTraceHook(TraceHook *hook) {
+    tracing_detail::getHookStorage().store(hook, std::memory_order_release);
+  }
+
+  inline TraceHook * getTraceHook() {
+    return tracing_detail::getHookStorage().load(std::memory_order_acquire);
+  }
+
+  /**
+   * Periodically drains `TraceBuffer::shared()` on a background thread and passes the events
+   * to `sink`. Remaining events are drained when the exporter is destroyed.
+   */
+  class TraceExporter {
+  public:
+    using Sink = std::function<void(size_t thread, const TraceEvent &event)>;
+
+  private:
+    Sink sink;
+    std::chrono::milliseconds interval;
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool stopping = false;
+    std::thread worker;
+
+  public:
+    TraceExporter(Sink s, std::chrono::milliseconds i = std::chrono::milliseconds(100)):sink(std::move(s)),interval(i){
+      worker = std::thread([this](){
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+          condition.wait_for(lock, interval, [this](){ return stopping; });
+          lock.unlock();
+          flush();
+          lock.lock();
+        }
+      });
+    }
+
+    TraceExporter(const TraceExporter &) = delete;
+    TraceExporter &operator=(const TraceExporter &) = delete;
+
+    /**
+     * Drains all events recorded so far.
+     */
+    size_t flush() {
+      return TraceBuffer::shared().drain(sink);
+    }
+
+    ~TraceExporter() {
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+      }
+      condition.notify_all();
+      worker.join();
+      flush();
+    }
+  };
+
+  namespace tracing_detail {
+
+    /**
+     * Reports the visit of `visitable` by `visitor` to the trace hook for its lifetime.
+     * The disabled specialization is empty.
+     */
+    template <bool Enabled> class VisitSpan {
+    public:
+      template <class V, class Visitor> VisitSpan(const V &, const Visitor &){ }
+    };
+
+    template <> class VisitSpan<true> {
+    private:
+      TraceHook * hook;
+      TypeIndex visitable = getTypeIndex<void>();
+      TypeIndex visitor = getTypeIndex<void>();
+
+    public:
+      template <class V, class Visitor> VisitSpan(const V &v, const Visitor &w):hook(getTraceHook()){
+        if (hook) {
+          visitable = v.visitableType();
+          visitor = w.visitorType();
+          hook->beginVisit(visitable, visitor);
+        }
+      }
+
+      VisitSpan(const VisitSpan &) = delete;
+      VisitSpan &operator=(const VisitSpan &) = delete;
+
+      ~VisitSpan() {
+        if (hook) { hook->endVisit(visitable, visitor); }
+      }
+    };
+
+    /**
+     * Reports a call of `function` to the trace hook for its lifetime.
+     * The disabled specialization is empty.
+     */
+    template <bool Enabled> class CallSpan {
+    public:
+      template <class F> CallSpan(const F &){ }
+    };
+
+    template <> class CallSpan<true> {
+    private:
+      TraceHook * hook;
+      const AnyFunctionSignature * signature = nullptr;
+
+    public:
+      template <class F> CallSpan(const F &function):hook(getTraceHook()){
+        if (hook) {
+          signature = &function.signature();
+          hook->beginCall(*signature);
+        }
+      }
+
+      CallSpan(const CallSpan &) = delete;
+      CallSpan &operator=(const CallSpan &) = delete;
+
+      ~CallSpan() {
+        if (hook) { hook->endCall(*signature); }
+      }
+    };
+
+  }
+
+}
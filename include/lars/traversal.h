@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <lars/thread_pool.h>
+#include <lars/visitor.h>
+
+namespace lars {
+
+  enum class TraversalOrder {
+    /**
+     * Nodes are visited before their children. Returning `true` from a visit method skips
+     * the children of the node.
+     */
+    preOrder,
+    /**
+     * Nodes are visited after their children. The return value of visit methods is ignored.
+     */
+    postOrder,
+    /**
+     * Nodes are visited level by level. Returning `true` from a visit method skips the
+     * children of the node.
+     */
+    breadthFirst
+  };
+
+  namespace traversal_detail {
+
+    /**
+     * The set of visited nodes keyed by address. Synchronized if `mutex` is set.
+     */
+    class VisitedSet {
+    private:
+      std::unordered_set<const VisitableBase *> nodes;
+      std::mutex * mutex;
+
+    public:
+      explicit VisitedSet(std::mutex * m = nullptr):mutex(m){ }
+
+      /**
+       * Returns `true`, if `node` has not been inserted before.
+       */
+      bool insert(const VisitableBase * node) {
+        if (mutex) {
+          std::lock_guard<std::mutex> lock(*mutex);
+          return nodes.insert(node).second;
+        }
+        return nodes.insert(node).second;
+      }
+    };
+
+  }
+
+  /**
+   * Walks a graph of visitable objects using an explicit stack, so that deep graphs do not
+   * overflow the call stack. The children of a node are obtained from the `Children` hook,
+   * which appends them to the provided vector in visiting order.
+   * Every node is accepted by a `RecursiveVisitor`. Depending on the order, the return value
+   * of the visit method prunes the children of the node.
+   * If `deduplicate` is set, every node is visited at most once, which is required for
+   * graphs containing cycles and avoids repeated visits of shared nodes in DAGs.
+   */
+  class Traversal {
+  public:
+    using Children = std::function<void(VisitableBase &node, std::vector<VisitableBase *> &children)>;
+
+  private:
+    Children children;
+    TraversalOrder order;
+    bool deduplicate;
+
+    size_t walkPreOrder(VisitableBase &root, RecursiveVisitorBase &visitor, traversal_detail::VisitedSet &visited) const {
+      size_t count = 0;
+      std::vector<VisitableBase *> stack{&root};
+      std::vector<VisitableBase *> buffer;
+      while (!stack.empty()) {
+        auto node = stack.back();
+        stack.pop_back();
+        ++count;
+        if (node->accept(visitor)) { continue; }
+        buffer.clear();
+        children(*node, buffer);
+        for (auto it = buffer.rbegin(); it != buffer.rend(); ++it) {
+          if (!deduplicate || visited.insert(*it)) { stack.push_back(*it); }
+        }
+      }
+      return count;
+    }
+
+    /**
+     * Nodes are marked as visited when they are expanded rather than when they are pushed,
+     * so that a node shared in a DAG is visited after all of its children. `root` has
+     * already been marked by the caller.
+     */
+    size_t walkPostOrder(VisitableBase &root, RecursiveVisitorBase &visitor, traversal_detail::VisitedSet &visited) const {
+      size_t count = 0;
+      std::vector<std::pair<VisitableBase *, bool>> stack{{&root, false}};
+      std::vector<VisitableBase *> buffer;
+      bool isRoot = true;
+      while (!stack.empty()) {
+        auto &top = stack.back();
+        auto node = top.first;
+        if (top.second) {
+          stack.pop_back();
+          ++count;
+          node->accept(visitor);
+          continue;
+        }
+        if (deduplicate && !isRoot && !visited.insert(node)) {
+          stack.pop_back();
+          continue;
+        }
+        isRoot = false;
+        top.second = true;
+        buffer.clear();
+        children(*node, buffer);
+        for (auto it = buffer.rbegin(); it != buffer.rend(); ++it) {
+          stack.emplace_back(*it, false);
+        }
+      }
+      return count;
+    }
+
+    size_t walkBreadthFirst(VisitableBase &root, RecursiveVisitorBase &visitor, traversal_detail::VisitedSet &visited) const {
+      size_t count = 0;
+      std::deque<VisitableBase *> queue{&root};
+      std::vector<VisitableBase *> buffer;
+      while (!queue.empty()) {
+        auto node = queue.front();
+        queue.pop_front();
+        ++count;
+        if (node->accept(visitor)) { continue; }
+        buffer.clear();
+        children(*node, buffer);
+        for (auto child: buffer) {
+          if (!deduplicate || visited.insert(child)) { queue.push_back(child); }
+        }
+      }
+      return count;
+    }
+
+    size_t walk(VisitableBase &root, RecursiveVisitorBase &visitor, traversal_detail::VisitedSet &visited) const {
+      switch (order) {
+        case TraversalOrder::preOrder: return walkPreOrder(root, visitor, visited);
+        case TraversalOrder::postOrder: return walkPostOrder(root, visitor, visited);
+        case TraversalOrder::breadthFirst: return walkBreadthFirst(root, visitor, visited);
+      }
+      return 0;
+    }
+
+  public:
+
+    explicit Traversal(Children c, TraversalOrder o = TraversalOrder::preOrder, bool d = false):children(std::move(c)),order(o),deduplicate(d){ }
+
+    Traversal & setOrder(TraversalOrder o) {
+      order = o;
+      return *this;
+    }
+
+    Traversal & setDeduplicate(bool d) {
+      deduplicate = d;
+      return *this;
+    }
+
+    TraversalOrder getOrder() const {
+      return order;
+    }
+
+    bool isDeduplicating() const {
+      return deduplicate;
+    }
+
+    /**
+     * Visits all nodes reachable from `root`.
+     * @return - the number of visited nodes.
+     */
+    size_t run(VisitableBase &root, RecursiveVisitorBase &visitor) const {
+      traversal_detail::VisitedSet visited;
+      if (deduplicate) { visited.insert(&root); }
+      return walk(root, visitor, visited);
+    }
+
+    /**
+     * Same as `run`, but the subtrees of the children of `root` are walked in parallel on
+     * `pool`. The order applies within each subtree; in post-order `root` is visited after
+     * all subtrees, otherwise before. The visitor is called concurrently and must be
+     * thread-safe. With `deduplicate` set, a node shared between subtrees is visited by
+     * the first subtree reaching it.
+     * @return - the number of visited nodes.
+     */
+    size_t runParallel(VisitableBase &root, RecursiveVisitorBase &visitor, ThreadPool &pool = ThreadPool::shared()) const {
+      std::mutex mutex;
+      traversal_detail::VisitedSet visited(&mutex);
+      if (deduplicate) { visited.insert(&root); }
+
+      if (order != TraversalOrder::postOrder && root.accept(visitor)) { return 1; }
+
+      std::vector<VisitableBase *> subtrees;
+      children(root, subtrees);
+      if (deduplicate) {
+        subtrees.erase(std::remove_if(subtrees.begin(), subtrees.end(), [&](auto node){ return !visited.insert(node); }), subtrees.end());
+      }
+
+      std::atomic<size_t> count{1};
+      pool.forEach(subtrees.size(), [&](size_t i){
+        count += walk(*subtrees[i], visitor, visited);
+      });
+
+      if (order == TraversalOrder::postOrder) { root.accept(visitor); }
+      return count;
+    }
+
+  };
+
+}
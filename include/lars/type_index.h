@@ -2,6 +2,11 @@
 
 #include <ctti/type_id.hpp>
 #include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
 
 namespace lars{
   
@@ -19,12 +24,21 @@ namespace lars{
   private:
     ctti::type_id_t type_index;
   public:
-    TypeIndex(ctti::type_id_t && t):StaticTypeIndex(t),type_index(t){ }
+    constexpr TypeIndex(ctti::type_id_t && t):StaticTypeIndex(t),type_index(t){ }
     std::string name() const { return type_index.name().cppstring(); }
+
+    /**
+     * The name of the type. The view refers to static storage and is valid for the lifetime
+     * of the process.
+     */
+    constexpr std::string_view nameView() const {
+      auto name = type_index.name();
+      return std::string_view(name.begin(), name.end() - name.begin());
+    }
   };
   
   template <class Ostream> Ostream &operator<<(Ostream &stream, const TypeIndex &idx) {
-    stream << idx.name();
+    stream << idx.nameView();
     return stream;
   }
   
@@ -36,13 +50,78 @@ namespace lars{
     return StaticTypeIndexFor<T>::value;
   }
   
-  template <class T> TypeIndex getTypeIndex(){
-    return TypeIndex(ctti::type_id<T>());
+  template <class T> struct TypeIndexFor {
+    static constexpr TypeIndex value = TypeIndex(ctti::type_id<T>());
+  };
+
+  template <class T> constexpr TypeIndex getTypeIndex(){
+    return TypeIndexFor<T>::value;
   }
 
   template <class T> std::string get_type_name(){
-    auto name = ctti::type_id<T>().name();
-    return std::string(name.begin(),name.end());
+    return std::string(getTypeIndex<T>().nameView());
+  }
+
+  namespace type_index_detail {
+
+    /**
+     * Removes the compiler specific whitespace around `&`, `*`, `<`, `>` and `,` and separates
+     * list elements by a single space, e.g. `TypeList<int &,const float &>` and
+     * `TypeList<int&, const float&>` both become `TypeList<int&, const float&>`.
+     */
+    inline std::string normalizeTypeName(std::string_view name) {
+      auto isPunctuation = [](char c){ return c == '&' || c == '*' || c == '<' || c == '>' || c == ','; };
+      std::string result;
+      result.reserve(name.size());
+      for (size_t i = 0; i < name.size(); ++i) {
+        char c = name[i];
+        if (c == ' ') {
+          bool afterPunctuation = !result.empty() && (isPunctuation(result.back()) || result.back() == ' ');
+          bool beforePunctuation = i + 1 < name.size() && isPunctuation(name[i + 1]);
+          if (afterPunctuation || beforePunctuation) { continue; }
+        }
+        result += c;
+        if (c == ',') { result += ' '; }
+      }
+      return result;
+    }
+
+    class TypeNameCache {
+    private:
+      std::shared_mutex mutex;
+      std::unordered_map<size_t, std::string> names;
+
+    public:
+      std::string_view get(const TypeIndex &idx) {
+        {
+          std::shared_lock<std::shared_mutex> lock(mutex);
+          auto it = names.find(idx.hash());
+          if (it != names.end()) { return it->second; }
+        }
+        auto name = normalizeTypeName(idx.nameView());
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        return names.emplace(idx.hash(), std::move(name)).first->second;
+      }
+    };
+
+    inline TypeNameCache & getTypeNameCache() {
+      static TypeNameCache cache;
+      return cache;
+    }
+
+  }
+
+  /**
+   * Returns the normalized name of the type `idx`, see `type_index_detail::normalizeTypeName`.
+   * Names are created once per type and cached for the lifetime of the process, so repeated
+   * calls, e.g. in diagnostics of visitor types, do not allocate.
+   */
+  inline std::string_view getPrettyTypeName(const TypeIndex &idx) {
+    return type_index_detail::getTypeNameCache().get(idx);
+  }
+
+  template <class T> std::string_view getPrettyTypeName() {
+    return getPrettyTypeName(getTypeIndex<T>());
   }
   
 }
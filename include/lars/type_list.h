@@ -1,6 +1,7 @@
 #pragma once
 
 #include <type_traits>
+#include <utility>
 
 namespace lars{
 
@@ -14,11 +15,39 @@ namespace lars{
     template <typename ... Other> using Merge = typename typelist::Merge<TypeList, Other...>::type;
     template <template <class> typename Filter> using Filter = typename typelist::Filter<TypeList, Filter>::type;
     template <template <class> typename T> using Transform = TypeList<typename T<Types>::type ...>;
-    template <class F, template <class> typename T> static constexpr auto transform(F && f){ return f(T<Types>()...); } 
+    template <class F, template <class> typename T> static constexpr auto transform(F && f){ return f(T<Types>()...); }
   };
 
   namespace typelist {
 
+    /**
+     * Constant time access to the `I`th element of a parameter pack.
+     * `Indexer` is instantiated once per pack, after which `At` is resolved through
+     * overload resolution instead of a recursive instantiation.
+     */
+    template <size_t I, class T> struct Indexed { using type = T; };
+    template <size_t I, class T> Indexed<I, T> select(const Indexed<I, T> &);
+
+    template <class Indices, typename ... Types> struct IndexerPrototype;
+    template <size_t ... Indices, typename ... Types> struct IndexerPrototype<std::index_sequence<Indices...>, Types...>: Indexed<Indices, Types> ... {};
+    template <typename ... Types> using Indexer = IndexerPrototype<std::index_sequence_for<Types...>, Types...>;
+
+    template <size_t I, class Indexer> using At = typename decltype(select<I>(std::declval<Indexer>()))::type;
+
+    template <size_t N> struct IndexArray {
+      size_t data[N + 1] = {};
+      constexpr size_t operator[](size_t i) const { return data[i]; }
+    };
+
+    /**
+     * Selects the elements at the positions stored in `Indices::values` of `Indexer`.
+     * `Indices::size` is the number of selected elements.
+     */
+    template <class Indices, class Indexer, template <typename ...> class List, class Sequence = std::make_index_sequence<Indices::size>> struct Select;
+    template <class Indices, class Indexer, template <typename ...> class List, size_t ... I> struct Select<Indices, Indexer, List, std::index_sequence<I...>> {
+      using type = List<At<Indices::values[I], Indexer>...>;
+    };
+
     template <typename ... ATypes, typename ... BTypes> struct Merge <TypeList<ATypes...>, TypeList<BTypes...>> {
       using type = TypeList<ATypes..., BTypes...>;
     };
@@ -27,21 +56,26 @@ namespace lars{
       using type = typename Merge<typename Merge<A,B>::type, Rest...>::type;
     };
 
-    template < template <class> typename F> struct Filter<TypeList<>, F> {
-      using type = TypeList<>;
+    template <bool ... Keep> struct FilterIndices {
+      static constexpr size_t size = (size_t(Keep) + ... + 0);
+      static constexpr IndexArray<size> values = []{
+        const bool keep[] = { Keep..., false };
+        IndexArray<size> result;
+        for (size_t i = 0, j = 0; j < size; ++i) {
+          if (keep[i]) { result.data[j++] = i; }
+        }
+        return result;
+      }();
     };
 
-    template <class First, typename ... Rest, template <class> typename F> struct Filter<TypeList<First, Rest...>, F> {
-    private:
-      using RestType = typename Filter<TypeList<Rest...>, F>::type;
-    public:
-      using type = typename std::conditional<
-        F<First>::value,
-        typename TypeList<First>::template Merge<RestType>,
-        RestType
+    template <typename ... Types, template <class> typename F> struct Filter<TypeList<Types...>, F> {
+      using type = typename Select<
+        FilterIndices<bool(F<Types>::value)...>,
+        Indexer<Types...>,
+        TypeList
       >::type;
     };
-    
+
   }
 
-}
\ No newline at end of file
+}
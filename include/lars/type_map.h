@@ -0,0 +1,324 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <lars/type_index.h>
+
+namespace lars {
+
+  /**
+   * Is raised when inserting into or erasing from a frozen TypeMap
+   */
+  struct FrozenTypeMapException: public std::exception {
+    const char * what() const noexcept override {
+      return "modified frozen TypeMap";
+    }
+  };
+
+  namespace type_map_detail {
+
+    /**
+     * Control bytes of the table. Full slots store the lower 7 bits of the hash.
+     */
+    constexpr uint8_t empty = 0x80;
+    constexpr uint8_t deleted = 0xFE;
+
+    constexpr size_t groupWidth = 8;
+    constexpr uint64_t lsbs = 0x0101010101010101ull;
+    constexpr uint64_t msbs = 0x8080808080808080ull;
+
+    /**
+     * A group of eight control bytes, probed in parallel using SWAR arithmetic.
+     * Each match is a bit mask with the most significant bit of every matching byte set.
+     */
+    struct Group {
+      uint64_t word = 0;
+
+      explicit Group(const uint8_t * control) {
+        std::memcpy(&word, control, sizeof(word));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+      }
+
+      /**
+       * May contain false positives after a true match, which are rejected by comparing hashes.
+       */
+      uint64_t match(uint8_t h2) const {
+        auto x = word ^ (lsbs * h2);
+        return (x - lsbs) & ~x & msbs;
+      }
+
+      uint64_t matchEmpty() const {
+        return word & (~word << 6) & msbs;
+      }
+
+      uint64_t matchEmptyOrDeleted() const {
+        return word & msbs;
+      }
+    };
+
+    inline size_t lowestByte(uint64_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+      return size_t(__builtin_ctzll(mask)) / 8;
+#else
+      size_t i = 0;
+      while (!(mask & 0x80)) { mask >>= 8; ++i; }
+      return i;
+#endif
+    }
+
+    inline uint8_t h2(size_t hash) { return uint8_t(hash & 0x7F); }
+    inline size_t h1(size_t hash) { return hash >> 7; }
+
+  }
+
+  /**
+   * A flat hash map with StaticTypeIndex keys.
+   * Values are stored contiguously in insertion order, erasing moves the last value into the
+   * erased position. The index table uses open addressing with groups of eight control bytes
+   * that are probed in parallel. As type indices are already well mixed hashes, they are used
+   * without further hashing.
+   * After calling `freeze()` the table is compacted and no further values can be inserted or
+   * erased, so that the map can be read concurrently.
+   */
+  template <class V> class TypeMap {
+  public:
+    using value_type = std::pair<StaticTypeIndex, V>;
+    using const_iterator = typename std::vector<value_type>::const_iterator;
+
+  private:
+    struct Slot {
+      size_t hash = 0;
+      uint32_t index = 0;
+    };
+
+    std::vector<value_type> entries;
+    std::vector<uint8_t> control;
+    std::vector<Slot> slots;
+    size_t groupMask = 0;
+    size_t deletedCount = 0;
+    bool frozen = false;
+
+    static constexpr size_t npos = size_t(-1);
+
+    /**
+     * Returns the slot storing `hash` or `npos`.
+     */
+    size_t findSlot(size_t hash) const {
+      if (slots.empty()) { return npos; }
+      auto g = type_map_detail::h1(hash) & groupMask;
+      auto h2 = type_map_detail::h2(hash);
+      for (size_t step = 1;; ++step) {
+        type_map_detail::Group group(&control[g * type_map_detail::groupWidth]);
+        for (auto m = group.match(h2); m; m &= m - 1) {
+          auto s = g * type_map_detail::groupWidth + type_map_detail::lowestByte(m);
+          if (slots[s].hash == hash) { return s; }
+        }
+        if (group.matchEmpty()) { return npos; }
+        g = (g + step) & groupMask;
+      }
+    }
+
+    size_t findInsertSlot(size_t hash) const {
+      auto g = type_map_detail::h1(hash) & groupMask;
+      for (size_t step = 1;; ++step) {
+        type_map_detail::Group group(&control[g * type_map_detail::groupWidth]);
+        if (auto m = group.matchEmptyOrDeleted()) {
+          return g * type_map_detail::groupWidth + type_map_detail::lowestByte(m);
+        }
+        g = (g + step) & groupMask;
+      }
+    }
+
+    void setSlot(size_t s, size_t hash, uint32_t index) {
+      if (control[s] == type_map_detail::deleted) { --deletedCount; }
+      control[s] = type_map_detail::h2(hash);
+      slots[s] = Slot{hash, index};
+    }
+
+    void rehash(size_t groups) {
+      control.assign(groups * type_map_detail::groupWidth, type_map_detail::empty);
+      slots.assign(groups * type_map_detail::groupWidth, Slot());
+      groupMask = groups - 1;
+      deletedCount = 0;
+      for (uint32_t i = 0; i < entries.size(); ++i) {
+        auto hash = entries[i].first.hash();
+        setSlot(findInsertSlot(hash), hash, i);
+      }
+    }
+
+    /**
+     * The smallest power of two number of groups keeping the load factor below 7/8.
+     */
+    static size_t groupsFor(size_t count) {
+      size_t groups = 1;
+      while (groups * type_map_detail::groupWidth * 7 <= count * 8) { groups *= 2; }
+      return groups;
+    }
+
+    void reserveForInsert() {
+      auto capacity = slots.size();
+      if ((entries.size() + deletedCount + 1) * 8 <= capacity * 7) { return; }
+      rehash(groupsFor(entries.size() + 1 + entries.size() / 2));
+    }
+
+    void checkMutable() const {
+      if (frozen) { throw FrozenTypeMapException(); }
+    }
+
+  public:
+
+    /**
+     * Returns a pointer to the value stored for `key` or `nullptr`, if no such value exists.
+     */
+    V * find(const StaticTypeIndex &key) {
+      auto s = findSlot(key.hash());
+      return s == npos ? nullptr : &entries[slots[s].index].second;
+    }
+
+    const V * find(const StaticTypeIndex &key) const {
+      auto s = findSlot(key.hash());
+      return s == npos ? nullptr : &entries[slots[s].index].second;
+    }
+
+    bool contains(const StaticTypeIndex &key) const {
+      return findSlot(key.hash()) != npos;
+    }
+
+    /**
+     * Same as `find`, but raises a `std::out_of_range` exception if no such value exists.
+     */
+    V & at(const StaticTypeIndex &key) {
+      if (auto v = find(key)) { return *v; }
+      throw std::out_of_range("TypeMap::at");
+    }
+
+    const V & at(const StaticTypeIndex &key) const {
+      if (auto v = find(key)) { return *v; }
+      throw std::out_of_range("TypeMap::at");
+    }
+
+    /**
+     * Inserts a value constructed from `args` if `key` is not contained.
+     * Returns a pointer to the value stored for `key` and `true`, if the value has been inserted.
+     * Raises a `FrozenTypeMapException` if the map is frozen and `key` is not contained.
+     */
+    template <typename ... Args> std::pair<V *, bool> emplace(const StaticTypeIndex &key, Args && ... args) {
+      if (auto v = find(key)) { return std::make_pair(v, false); }
+      checkMutable();
+      reserveForInsert();
+      entries.emplace_back(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple(std::forward<Args>(args)...));
+      setSlot(findInsertSlot(key.hash()), key.hash(), uint32_t(entries.size() - 1));
+      return std::make_pair(&entries.back().second, true);
+    }
+
+    /**
+     * Stores `value` for `key`, replacing a previously stored value.
+     * Raises a `FrozenTypeMapException` if the map is frozen and `key` is not contained.
+     */
+    V & set(const StaticTypeIndex &key, V value) {
+      if (auto v = find(key)) {
+        *v = std::move(value);
+        return *v;
+      }
+      return *emplace(key, std::move(value)).first;
+    }
+
+    /**
+     * Returns the value stored for `key`, inserting a default constructed value if `key` is
+     * not contained. Raises a `FrozenTypeMapException` if the map is frozen and `key` is not
+     * contained.
+     */
+    V & operator[](const StaticTypeIndex &key) {
+      return *emplace(key).first;
+    }
+
+    /**
+     * Removes the value stored for `key`. Returns `true`, if a value has been removed.
+     * Raises a `FrozenTypeMapException` if the map is frozen.
+     */
+    bool erase(const StaticTypeIndex &key) {
+      checkMutable();
+      auto s = findSlot(key.hash());
+      if (s == npos) { return false; }
+      auto index = slots[s].index;
+
+      auto groupStart = s - s % type_map_detail::groupWidth;
+      if (type_map_detail::Group(&control[groupStart]).matchEmpty()) {
+        control[s] = type_map_detail::empty;
+      } else {
+        control[s] = type_map_detail::deleted;
+        ++deletedCount;
+      }
+
+      if (index + 1 != entries.size()) {
+        slots[findSlot(entries.back().first.hash())].index = index;
+        entries[index] = std::move(entries.back());
+      }
+      entries.pop_back();
+      return true;
+    }
+
+    void clear() {
+      checkMutable();
+      entries.clear();
+      control.clear();
+      slots.clear();
+      groupMask = 0;
+      deletedCount = 0;
+    }
+
+    /**
+     * Rebuilds the table at the smallest capacity for the current size.
+     * Raises a `FrozenTypeMapException` if the map is frozen.
+     */
+    void shrinkToFit() {
+      checkMutable();
+      entries.shrink_to_fit();
+      if (entries.empty()) { clear(); } else { rehash(groupsFor(entries.size())); }
+    }
+
+    /**
+     * Compacts the map and prevents further insertions and removals. Values stored for
+     * contained keys can still be modified. Calling `freeze()` on a frozen map has no effect.
+     */
+    void freeze() {
+      if (frozen) { return; }
+      shrinkToFit();
+      frozen = true;
+    }
+
+    /**
+     * `true`, if `freeze()` has been called.
+     */
+    bool isFrozen() const {
+      return frozen;
+    }
+
+    size_t size() const {
+      return entries.size();
+    }
+
+    bool empty() const {
+      return entries.empty();
+    }
+
+    const_iterator begin() const {
+      return entries.begin();
+    }
+
+    const_iterator end() const {
+      return entries.end();
+    }
+
+  };
+
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+#include <lars/type_index.h>
+#include <lars/type_list.h>
+
+namespace lars {
+
+  /**
+   * A compile-time hash set of type indices.
+   * The table uses open addressing with a load factor of at most 1/2, so lookups
+   * usually need a single probe. The hashes of the types are also available in the order
+   * of the type list the set was created from.
+   */
+  class TypeSet {
+  private:
+    const size_t * table;
+    size_t mask;
+    size_t count;
+    const size_t * ordered;
+    size_t orderedCount;
+
+  public:
+    constexpr TypeSet(const size_t * t, size_t m, size_t c, const size_t * o, size_t oc):table(t),mask(m),count(c),ordered(o),orderedCount(oc){ }
+
+    /**
+     * `true`, if the set contains the type `idx`.
+     */
+    constexpr bool contains(const StaticTypeIndex &idx) const {
+      auto h = idx.hash();
+      for (auto i = h & mask;; i = (i + 1) & mask) {
+        if (table[i] == h) { return true; }
+        if (table[i] == 0) { return false; }
+      }
+    }
+
+    /**
+     * The number of types in the set.
+     */
+    constexpr size_t size() const {
+      return count;
+    }
+
+    /**
+     * The hashes of the types in the order of the original type list.
+     */
+    constexpr const size_t * begin() const {
+      return ordered;
+    }
+
+    constexpr const size_t * end() const {
+      return ordered + orderedCount;
+    }
+  };
+
+  namespace type_set_detail {
+
+    constexpr size_t capacityFor(size_t count) {
+      size_t capacity = 2;
+      while (capacity < 2 * count) { capacity *= 2; }
+      return capacity;
+    }
+
+    template <class L> struct TypeSetTable;
+
+    template <typename ... Types> struct TypeSetTable<TypeList<Types...>> {
+      static constexpr size_t capacity = capacityFor(sizeof...(Types));
+
+      struct Data {
+        std::array<size_t, capacity> table{};
+        size_t count = 0;
+      };
+
+      static constexpr std::array<size_t, sizeof...(Types) + 1> hashes{ getStaticTypeIndex<Types>().hash()..., 0 };
+
+      static constexpr Data build() {
+        Data data{};
+        for (size_t k = 0; k < sizeof...(Types); ++k) {
+          auto h = hashes[k];
+          for (auto i = h & (capacity - 1);; i = (i + 1) & (capacity - 1)) {
+            if (data.table[i] == h) { break; }
+            if (data.table[i] == 0) {
+              data.table[i] = h;
+              ++data.count;
+              break;
+            }
+          }
+        }
+        return data;
+      }
+
+      static constexpr Data data = build();
+      static constexpr TypeSet value = TypeSet(data.table.data(), capacity - 1, data.count, hashes.data(), sizeof...(Types));
+    };
+
+  }
+
+  /**
+   * Returns the set of the types contained in the TypeList `L`.
+   * The returned object is unique for every type list and can be compared by address.
+   */
+  template <class L> constexpr const TypeSet & getTypeSet() {
+    return type_set_detail::TypeSetTable<L>::value;
+  }
+
+}
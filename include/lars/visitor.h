@@ -2,17 +2,25 @@
 
 #include <array>
 #include <cstddef>
+#include <map>
+#include <memory>
+#include <shared_mutex>
 #include <stdexcept>
 #include <string>
 #include <type_traits>
 #include <optional>
+#include <utility>
 
 #include <lars/inheritance_list.h>
+#include <lars/statistics.h>
+#include <lars/tracing.h>
 #include <lars/type_index.h>
+#include <lars/type_set.h>
 
 namespace lars {
 
   template <class T> class SingleVisitor;
+  class VisitableBase;
   
   template <class SingleBase, template <class T> class Single> class VisitorBasePrototype {
   public:
@@ -23,6 +31,15 @@ namespace lars {
     }
 
     virtual TypeIndex visitorType() const = 0;
+
+    /**
+     * Called by the regular visitor algorithm if the visitor has no visit method for the
+     * visitable object, for const and non-const objects alike. By default raises an
+     * `InvalidVisitorException`. Override to handle unknown objects without an exception
+     * being constructed. Only used by regular visitors: recursive visitors return `false`
+     * from `accept` instead and never call it.
+     */
+    virtual void visitDefault(const VisitableBase &visitable);
     
     virtual ~VisitorBasePrototype(){}
   };
@@ -79,7 +96,8 @@ namespace lars {
    * All types that are visitable by this class are provided in the template arguments,
    * usually as references or const references.
    * When accepted, the first matching visit method will be called.
-   * If no matching visit method exists, a `InvalidVisitorException` will be thrown.
+   * If no matching visit method exists, `visitDefault` will be called, which raises an
+   * `InvalidVisitorException` unless overridden.
    */
   template <typename ... Args> using Visitor = VisitorPrototype<
     SingleVisitorBase,
@@ -108,7 +126,8 @@ namespace lars {
    * All types that are visitable by this class are provided in the template arguments,
    * usually as references or const references.
    * When accepted, all first matching visit methods will be called until the return
-   * value of a visit method is `true`.
+   * value of a visit method is `true`. Objects without a matching visit method are skipped,
+   * `visitDefault` is not called.
    */
   using RecursiveVisitorBase = VisitorBasePrototype<SingleRecursiveVisitorBase, SingleRecursiveVisitor>;
   template <typename ... Args> using RecursiveVisitor = VisitorPrototype<SingleRecursiveVisitorBase, SingleRecursiveVisitor, Args...>;
@@ -120,18 +139,65 @@ namespace lars {
    */
   class InvalidVisitorException: public std::exception {
   private:
-    mutable std::string buffer;
+    mutable const char * message = nullptr;
+    std::shared_ptr<const std::string> customMessage;
+
+    /**
+     * Process-wide cache of the messages by visitable and visitor type, so that repeated
+     * failures of the same visit do not allocate.
+     */
+    class MessageCache {
+    private:
+      std::shared_mutex mutex;
+      std::map<std::pair<size_t, size_t>, std::string> messages;
+
+    public:
+      const char * get(const TypeIndex &visitable, const TypeIndex &visitor) {
+        auto key = std::make_pair(visitable.hash(), visitor.hash());
+        {
+          std::shared_lock<std::shared_mutex> lock(mutex);
+          auto it = messages.find(key);
+          if (it != messages.end()) { return it->second.c_str(); }
+        }
+        std::string result = "invalid visitor for ";
+        result += getPrettyTypeName(visitable);
+        result += ". Expected types: ";
+        result += getPrettyTypeName(visitor);
+        std::unique_lock<std::shared_mutex> lock(mutex);
+        return messages.emplace(key, std::move(result)).first->second.c_str();
+      }
+    };
+
+    static MessageCache & getMessageCache() {
+      static MessageCache cache;
+      return cache;
+    }
     
   public:
     TypeIndex visitableType;
     TypeIndex visitorType;
-    InvalidVisitorException(TypeIndex t, TypeIndex v = getTypeIndex<TypeList<>>()): visitableType(t), visitorType(v){}
+    InvalidVisitorException(TypeIndex t, TypeIndex v = getTypeIndex<TypeList<>>()): visitableType(t), visitorType(v){
+      if constexpr (statisticsEnabled) { statistics_detail::recordInvalidVisitorException(); }
+    }
+
+    /**
+     * Lists `expectedTypes` in the message instead of the visitor type, for visitors whose
+     * types are only known at run time.
+     */
+    InvalidVisitorException(TypeIndex t, TypeIndex v, std::string_view expectedTypes): InvalidVisitorException(t, v){
+      std::string result = "invalid visitor for ";
+      result += getPrettyTypeName(visitableType);
+      result += ". Expected types: ";
+      result += expectedTypes;
+      customMessage = std::make_shared<const std::string>(std::move(result));
+      message = customMessage->c_str();
+    }
     
     const char * what() const noexcept override {
-      if (buffer.size() == 0){
-        buffer = "invalid visitor for " + visitableType.name() + ". Expected types: " + visitorType.name();
+      if (!message){
+        message = getMessageCache().get(visitableType, visitorType);
       }
-      return buffer.c_str();
+      return message;
     }
   };
   
@@ -146,8 +212,46 @@ namespace lars {
     virtual void accept(VisitorBase &visitor) const = 0;
     virtual bool accept(RecursiveVisitorBase &) = 0;
     virtual bool accept(RecursiveVisitorBase &) const = 0;
+
+    /**
+     * The set of types accepted by a const visitor. Used by `isA` to test types without
+     * visiting.
+     */
+    virtual const TypeSet & visitableTypeSet() const { return getTypeSet<TypeList<>>(); }
+
+    /**
+     * The address of the object converted to the `index`th type of `visitableTypeSet()`,
+     * or `nullptr` if that type is not a reference. Used by `visit2` to convert objects
+     * without visiting.
+     */
+    virtual const void * visitableAddress(size_t) const { return nullptr; }
+
+    /**
+     * The set of types accepted by a non-const visitor. Objects that only expose a const
+     * interface, such as values captured through `std::reference_wrapper<const T>`, contain
+     * no non-const reference types.
+     */
+    virtual const TypeSet & visitableMutableTypeSet() { return getTypeSet<TypeList<>>(); }
+
+    /**
+     * The address of the object converted to the `index`th type of
+     * `visitableMutableTypeSet()`, or `nullptr` if that type is not a non-const reference.
+     */
+    virtual void * visitableMutableAddress(size_t) { return nullptr; }
+
+    /**
+     * The type of the object storing the visited value. Differs from `visitableType` for
+     * data visitables, including those referencing values owned elsewhere, such as
+     * `std::reference_wrapper` or `std::shared_ptr`.
+     */
+    virtual TypeIndex storageType() const { return visitableType(); }
+
     virtual ~VisitableBase(){}
   };
+
+  template <class SingleBase, template <class T> class Single> void VisitorBasePrototype<SingleBase, Single>::visitDefault(const VisitableBase &visitable) {
+    throw InvalidVisitorException(visitable.visitableType(), visitorType());
+  }
   
   /**
    * Base class for indirect visitable objects.
@@ -155,40 +259,62 @@ namespace lars {
    */
   struct IndirectVisitableBase { };
 
+  /**
+   * Records a dispatch in the statistics if enabled. `probes` is the number of candidate
+   * types tested.
+   */
+  template <class V, class Visitor> void recordDispatch(const V * visitable, const Visitor &visitor, size_t probes, bool hit) {
+    if constexpr (statisticsEnabled) {
+      statistics_detail::recordDispatch(visitable->visitableType(), visitor.visitorType(), probes, hit);
+    }
+  }
+
   /**
    * The regular visitor algorithm.
+   * `depth` is the position of `T` in the visitable's types.
    */
   template <class V, class T, typename ... Rest> static void visit(
     V * visitable,
     TypeList<T, Rest...>,
-    VisitorBase &visitor
+    VisitorBase &visitor,
+    size_t depth = 0
   ) {
     if (auto *v = visitor.asVisitorFor<T>()) {
+      recordDispatch(visitable, visitor, depth + 1, true);
+      tracing_detail::VisitSpan<tracingEnabled> span(*visitable, visitor);
       if constexpr (std::is_base_of<IndirectVisitableBase, typename std::decay<V>::type>::value){
         v->visit(visitable->template cast<T>());
       } else {
         v->visit(static_cast<T>(*visitable));
       }
     } else if constexpr (sizeof...(Rest) > 0) {
-      visit(visitable, TypeList<Rest...>(), visitor);
+      visit(visitable, TypeList<Rest...>(), visitor, depth + 1);
     } else {
-      throw InvalidVisitorException(getTypeIndex<V>(), visitor.visitorType());
+      recordDispatch(visitable, visitor, depth + 1, false);
+      tracing_detail::VisitSpan<tracingEnabled> span(*visitable, visitor);
+      visitor.visitDefault(*visitable);
     }
   }
   
-  template <class V> static bool visit(V *, TypeList<>, VisitorBase &visitor) {
-    throw InvalidVisitorException(getTypeIndex<V>(), visitor.visitorType());
+  template <class V> static void visit(V * visitable, TypeList<>, VisitorBase &visitor) {
+    recordDispatch(visitable, visitor, 0, false);
+    tracing_detail::VisitSpan<tracingEnabled> span(*visitable, visitor);
+    visitor.visitDefault(*visitable);
   }
   
   /**
    * The recursive visitor algorithm.
+   * As several visit methods may be called, only hits are recorded in the statistics.
    */
   template <class V, class T, typename ... Rest> static bool visit(
     V * visitable,
     TypeList<T, Rest...>,
-    RecursiveVisitorBase &visitor
+    RecursiveVisitorBase &visitor,
+    size_t depth = 0
   ) {
     if (auto *v = visitor.asVisitorFor<T>()) {
+      recordDispatch(visitable, visitor, depth + 1, true);
+      tracing_detail::VisitSpan<tracingEnabled> span(*visitable, visitor);
       if constexpr (std::is_base_of<IndirectVisitableBase, typename std::decay<V>::type>::value){
         if (v->visit(visitable->template cast<T>())) {
           return true;
@@ -200,7 +326,7 @@ namespace lars {
       }
     }
     if constexpr (sizeof...(Rest) > 0) {
-      return visit(visitable, TypeList<Rest...>(), visitor);
+      return visit(visitable, TypeList<Rest...>(), visitor, depth + 1);
     } else {
       return false;
     }
@@ -210,6 +336,52 @@ namespace lars {
     return false;
   }
   
+  /**
+   * Converts a visitable object to the reference type `T` and returns its address.
+   */
+  template <class V, class T> static const void * getVisitableAddressAs(const V * visitable) {
+    if constexpr (!std::is_reference<T>::value) {
+      return nullptr;
+    } else if constexpr (std::is_base_of<IndirectVisitableBase, typename std::decay<V>::type>::value){
+      return &visitable->template cast<T>();
+    } else {
+      return &static_cast<T>(*visitable);
+    }
+  }
+
+  /**
+   * Returns the address of the visitable object converted to the `index`th type of `Types`.
+   * The conversion functions are stored in a static table, so no visitor is required.
+   */
+  template <class V, typename ... Types> static const void * getVisitableAddress(const V * visitable, TypeList<Types...>, size_t index) {
+    using Getter = const void * (*)(const V *);
+    static constexpr Getter getters[] = { &getVisitableAddressAs<V, Types>..., nullptr };
+    return getters[index] ? getters[index](visitable) : nullptr;
+  }
+
+  /**
+   * Converts a visitable object to the non-const reference type `T` and returns its address.
+   */
+  template <class V, class T> static void * getMutableVisitableAddressAs(V * visitable) {
+    if constexpr (!std::is_reference<T>::value || std::is_const<typename std::remove_reference<T>::type>::value) {
+      return nullptr;
+    } else if constexpr (std::is_base_of<IndirectVisitableBase, typename std::decay<V>::type>::value){
+      return &visitable->template cast<T>();
+    } else {
+      return &static_cast<T>(*visitable);
+    }
+  }
+
+  /**
+   * Returns the address of the visitable object converted to the `index`th type of `Types`
+   * if that type is a non-const reference.
+   */
+  template <class V, typename ... Types> static void * getMutableVisitableAddress(V * visitable, TypeList<Types...>, size_t index) {
+    using Getter = void * (*)(V *);
+    static constexpr Getter getters[] = { &getMutableVisitableAddressAs<V, Types>..., nullptr };
+    return getters[index] ? getters[index](visitable) : nullptr;
+  }
+
   /**
    * An "empty" visitable object. When visited, no matching visitor methods will be found.
    */
@@ -224,6 +396,7 @@ namespace lars {
     bool accept(RecursiveVisitorBase &) override { return false; }
     bool accept(RecursiveVisitorBase &) const override { return false; }
     TypeIndex visitableType() const override { return getTypeIndex<void>(); }
+    const TypeSet & visitableTypeSet() const override { return getTypeSet<ConstTypes>(); }
   };
   
   /**
@@ -256,6 +429,22 @@ namespace lars {
     TypeIndex visitableType() const override {
       return getTypeIndex<T>();
     }
+
+    const TypeSet & visitableTypeSet() const override {
+      return getTypeSet<ConstTypes>();
+    }
+
+    const void * visitableAddress(size_t index) const override {
+      return getVisitableAddress(this, ConstTypes(), index);
+    }
+
+    const TypeSet & visitableMutableTypeSet() override {
+      return getTypeSet<Types>();
+    }
+
+    void * visitableMutableAddress(size_t index) override {
+      return getMutableVisitableAddress(this, Types(), index);
+    }
     
   };
   
@@ -295,6 +484,22 @@ namespace lars {
       return getTypeIndex<T>();
     }
 
+    const TypeSet & visitableTypeSet() const override {
+      return getTypeSet<ConstTypes>();
+    }
+
+    const void * visitableAddress(size_t index) const override {
+      return getVisitableAddress(this, ConstTypes(), index);
+    }
+
+    const TypeSet & visitableMutableTypeSet() override {
+      return getTypeSet<Types>();
+    }
+
+    void * visitableMutableAddress(size_t index) override {
+      return getMutableVisitableAddress(this, Types(), index);
+    }
+
   };
   
   /**
@@ -330,6 +535,22 @@ namespace lars {
       return getTypeIndex<JoinVisitable>();
     }
 
+    const TypeSet & visitableTypeSet() const override {
+      return getTypeSet<ConstTypes>();
+    }
+
+    const void * visitableAddress(size_t index) const override {
+      return getVisitableAddress(this, ConstTypes(), index);
+    }
+
+    const TypeSet & visitableMutableTypeSet() override {
+      return getTypeSet<Types>();
+    }
+
+    void * visitableMutableAddress(size_t index) override {
+      return getMutableVisitableAddress(this, Types(), index);
+    }
+
   };
 
   /**
@@ -365,6 +586,22 @@ namespace lars {
     TypeIndex visitableType() const override {
       return getTypeIndex<VirtualVisitable>();
     }
+
+    const TypeSet & visitableTypeSet() const override {
+      return getTypeSet<ConstTypes>();
+    }
+
+    const void * visitableAddress(size_t index) const override {
+      return getVisitableAddress(this, ConstTypes(), index);
+    }
+
+    const TypeSet & visitableMutableTypeSet() override {
+      return getTypeSet<Types>();
+    }
+
+    void * visitableMutableAddress(size_t index) override {
+      return getMutableVisitableAddress(this, Types(), index);
+    }
     
   };
 
@@ -413,6 +650,26 @@ namespace lars {
     TypeIndex visitableType() const override {
       return getTypeIndex<typename std::decay<BaseCast>::type>();
     }
+
+    const TypeSet & visitableTypeSet() const override {
+      return getTypeSet<ConstTypes>();
+    }
+
+    const void * visitableAddress(size_t index) const override {
+      return getVisitableAddress(this, ConstTypes(), index);
+    }
+
+    const TypeSet & visitableMutableTypeSet() override {
+      return getTypeSet<Types>();
+    }
+
+    void * visitableMutableAddress(size_t index) override {
+      return getMutableVisitableAddress(this, Types(), index);
+    }
+
+    TypeIndex storageType() const override {
+      return getTypeIndex<DataVisitablePrototype>();
+    }
     
     template <typename O> O cast(){
       return static_cast<O>(data);
@@ -542,6 +799,14 @@ namespace lars {
     }
   }
 
+  /**
+   * Tests if a visitable object can be visited as `const T &`, i.e. if `T` is the type of the
+   * object or one of its visitable bases. Runs in constant time without visiting the object.
+   */
+  template <class T> bool isA(const VisitableBase & v) {
+    return v.visitableTypeSet().contains(getStaticTypeIndex<const typename std::decay<T>::type &>());
+  }
+
   /**
    * Casts a reference of a visitable type to the type `T` using the visitor pattern.
    * @param - a pointer to an object derived from VisitableBase.
@@ -569,9 +834,13 @@ using InheritanceList = ::lars::InheritanceList<>;\
 using Type = ::lars::EmptyVisitable;\
 using Types = ::lars::TypeList<>;\
 using ConstTypes = ::lars::TypeList<>;\
-void accept(::lars::VisitorBase &visitor)override{ throw ::lars::InvalidVisitorException(visitableType()); }\
-void accept(::lars::VisitorBase &visitor) const override { throw ::lars::InvalidVisitorException(visitableType()); }\
+void accept(::lars::VisitorBase &visitor)override{ visitor.visitDefault(*this); }\
+void accept(::lars::VisitorBase &visitor) const override { visitor.visitDefault(*this); }\
 bool accept(::lars::RecursiveVisitorBase &visitor) override { return false; }\
 bool accept(::lars::RecursiveVisitorBase &visitor) const override { return false; }\
-::lars::TypeIndex visitableType() const override { return ::lars::getTypeIndex<::lars::EmptyVisitable>(); }
+::lars::TypeIndex visitableType() const override { return ::lars::getTypeIndex<::lars::EmptyVisitable>(); }\
+const ::lars::TypeSet & visitableTypeSet() const override { return ::lars::getTypeSet<::lars::TypeList<>>(); }\
+const void * visitableAddress(size_t) const override { return nullptr; }\
+const ::lars::TypeSet & visitableMutableTypeSet() override { return ::lars::getTypeSet<::lars::TypeList<>>(); }\
+void * visitableMutableAddress(size_t) override { return nullptr; }
 
@@ -0,0 +1,86 @@
+#include <catch2/catch.hpp>
+
+#include <lars/any.h>
+#include <lars/any_accounting.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+  using namespace lars;
+
+  struct Payload {
+    char data[256];
+  };
+}
+
+TEST_CASE("Any accounting", "[accounting]"){
+  REQUIRE(anyAccountingEnabled);
+
+  auto before = getAnyAllocations<Payload>();
+  REQUIRE(before.type == getStaticTypeIndex<Payload>());
+
+  SECTION("live objects and bytes"){
+    {
+      Any a = Payload();
+      auto b = makeAny<Payload>();
+      auto counters = getAnyAllocations<Payload>();
+      REQUIRE(counters.live == before.live + 2);
+      REQUIRE(counters.allocations == before.allocations + 2);
+      REQUIRE(counters.bytes - before.bytes >= int64_t(2 * sizeof(Payload)));
+
+      a.reset();
+      REQUIRE(getAnyAllocations<Payload>().live == before.live + 1);
+      REQUIRE(getAnyAllocations<Payload>().bytes == before.bytes + (counters.bytes - before.bytes) / 2);
+    }
+    auto counters = getAnyAllocations<Payload>();
+    REQUIRE(counters.live == before.live);
+    REQUIRE(counters.bytes == before.bytes);
+    REQUIRE(counters.allocations == before.allocations + 2);
+  }
+
+  SECTION("copies share the payload"){
+    Any a = Payload();
+    AnyReference b = a;
+    REQUIRE(getAnyAllocations<Payload>().live == before.live + 1);
+  }
+
+  SECTION("references are not accounted"){
+    Payload payload;
+    Any a = std::reference_wrapper<Payload>(payload);
+    REQUIRE(getAnyAllocations<Payload>().live == before.live);
+  }
+
+  SECTION("released on another thread"){
+    Any a = Payload();
+    std::thread([&](){ a.reset(); }).join();
+    auto counters = getAnyAllocations<Payload>();
+    REQUIRE(counters.live == before.live);
+    REQUIRE(counters.bytes == before.bytes);
+  }
+
+  SECTION("allocated on exited threads"){
+    std::vector<Any> values(4);
+    std::vector<std::thread> threads;
+    for (auto &value: values) {
+      threads.emplace_back([&](){ value = Payload(); });
+    }
+    for (auto &thread: threads) { thread.join(); }
+    REQUIRE(getAnyAllocations<Payload>().live == before.live + 4);
+    values.clear();
+    REQUIRE(getAnyAllocations<Payload>().live == before.live);
+  }
+
+  SECTION("ordered by bytes"){
+    Any a = Payload();
+    Any b = std::string("a");
+    auto allocations = getAnyAllocations();
+    REQUIRE(allocations.size() >= 2);
+    for (size_t i = 1; i < allocations.size(); ++i) {
+      REQUIRE(allocations[i - 1].bytes >= allocations[i].bytes);
+    }
+    REQUIRE(allocations.front().type == getStaticTypeIndex<Payload>());
+  }
+
+}
@@ -76,6 +76,51 @@ TEST_CASE("Reassign", "[any]"){
   }
 }
 
+TEST_CASE("Assign", "[any]"){
+  Any v;
+  REQUIRE(v.tryGetUnique<int>() == nullptr);
+  v.assign<int>(1);
+  REQUIRE(v.get<int>() == 1);
+
+  auto stored = v.tryGetUnique<int>();
+  REQUIRE(stored == &v.get<int &>());
+  v.assign<int>(2);
+  REQUIRE(&v.get<int &>() == stored);
+  REQUIRE(v.get<int>() == 2);
+  REQUIRE(v.tryGetUnique<double>() == nullptr);
+
+  SECTION("shared value"){
+    AnyReference r = v;
+    REQUIRE(v.tryGetUnique<int>() == nullptr);
+    v.assign<int>(3);
+    REQUIRE(r.get<int>() == 2);
+    REQUIRE(v.get<int>() == 3);
+  }
+
+  SECTION("other type"){
+    v.assign<std::string>("three");
+    REQUIRE(v.get<std::string>() == "three");
+  }
+
+  SECTION("reference"){
+    int external = 0;
+    v = std::ref(external);
+    REQUIRE(v.tryGetUnique<int>() == nullptr);
+    v.assign<int>(5);
+    REQUIRE(external == 0);
+    REQUIRE(v.get<int>() == 5);
+  }
+
+  SECTION("shared pointer"){
+    auto shared = std::make_shared<int>(1);
+    v = shared;
+    REQUIRE(v.tryGetUnique<int>() == nullptr);
+    v.assign<int>(9);
+    REQUIRE(*shared == 1);
+    REQUIRE(v.get<int>() == 9);
+  }
+}
+
 TEST_CASE("Any string conversions", "[any]"){
   Any v = "Hello any!";
   REQUIRE(v.get<std::string &>() == "Hello any!");
@@ -84,6 +129,9 @@ TEST_CASE("Any string conversions", "[any]"){
   REQUIRE(v.tryGet<std::string>()== &v.get<std::string &>());
   REQUIRE_THROWS_AS(v.get<int>(), InvalidVisitorException);
   REQUIRE(v.tryGet<int>() == nullptr);
+  REQUIRE(v.holds<std::string>());
+  REQUIRE(!v.holds<int>());
+  REQUIRE(!Any().holds<int>());
 }
 
 TEMPLATE_TEST_CASE("Numerics", "[any]", char, int, long, long long, unsigned char, unsigned int, unsigned long, unsigned long long, float, double) {
@@ -167,6 +215,15 @@ TEST_CASE("Inheritance", "[any]"){
       REQUIRE(v.get<const E &>().e == 'E');
     }
 
+    SECTION("holds"){
+      auto v = Any::withBases<C,B,A>();
+      REQUIRE(v.holds<A>());
+      REQUIRE(v.holds<const B &>());
+      REQUIRE(v.holds<C>());
+      REQUIRE(!v.holds<D>());
+      REQUIRE(!v.holds<E>());
+    }
+
   }
 }
 
@@ -193,6 +250,11 @@ TEST_CASE("Visitable inheritance","[any]"){
   REQUIRE_THROWS_AS(v.get<std::shared_ptr<C>>(), InvalidVisitorException);
   REQUIRE(v.get<std::shared_ptr<D>>()->name == 'D');
   REQUIRE(v.get<std::shared_ptr<E>>()->name == 'E');
+  REQUIRE(v.holds<A>());
+  REQUIRE(v.holds<B>());
+  REQUIRE(!v.holds<C>());
+  REQUIRE(v.holds<D>());
+  REQUIRE(v.holds<E>());
 }
 
 TEST_CASE("capture reference","[any]"){
@@ -214,6 +276,20 @@ TEST_CASE("capture const reference","[any]"){
   REQUIRE(y.get<double>() == 1);
 }
 
+TEST_CASE("capture const any","[any]"){
+  Any x = 1;
+  Any y;
+  y.setConstReference(x);
+  REQUIRE(y.type() == getStaticTypeIndex<int>());
+  REQUIRE(&y.get<const int &>() == &x.get<const int &>());
+  REQUIRE(y.get<double>() == 1);
+  REQUIRE(y.holds<int>());
+  REQUIRE_THROWS_AS(y.get<int &>(), InvalidVisitorException);
+  REQUIRE(y.tryGet<int>() == nullptr);
+  y.setConstReference(Any());
+  REQUIRE(!y);
+}
+
 TEST_CASE("AnyReference","[any]"){
   Any x = 1;
   AnyReference y;
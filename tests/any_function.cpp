@@ -62,6 +62,253 @@ TEST_CASE("call with arguments","[any_function]"){
   REQUIRE_THROWS_AS(f(1,2,3), AnyFunctionInvalidArgumentCountException);
 }
 
+TEST_CASE("signature","[any_function]"){
+  AnyFunction f;
+  REQUIRE_THROWS_AS(f.signature(), UndefinedAnyFunctionException);
+
+  SECTION("with arguments"){
+    f = [](int, const std::string &){ return 0.5; };
+    auto & signature = f.signature();
+    REQUIRE(signature.returnType == getStaticTypeIndex<double>());
+    REQUIRE(signature.argumentCount == 2);
+    REQUIRE(!signature.isVariadic);
+    std::vector<StaticTypeIndex> argumentTypes(signature.begin(), signature.end());
+    REQUIRE(argumentTypes == std::vector<StaticTypeIndex>{getStaticTypeIndex<int>(), getStaticTypeIndex<std::string>()});
+    AnyFunction g = [](int, const std::string &){ return 1.5; };
+    REQUIRE(&g.signature() == &signature);
+  }
+
+  SECTION("variadic"){
+    f = [](const AnyArguments &){};
+    auto & signature = f.signature();
+    REQUIRE(signature.returnType == getStaticTypeIndex<void>());
+    REQUIRE(signature.argumentCount == 0);
+    REQUIRE(signature.isVariadic);
+    REQUIRE(signature.begin() == signature.end());
+  }
+}
+
+TEST_CASE("call with result slot","[any_function]"){
+  AnyFunction f = [](int a, int b){ return a + b; };
+  
+  SECTION("any result"){
+    Any result;
+    f.call({1, 2}, result);
+    REQUIRE(result.get<int>() == 3);
+    auto stored = &result.get<int &>();
+    f.call({2, 3}, result);
+    REQUIRE(&result.get<int &>() == stored);
+    REQUIRE(result.get<int>() == 5);
+
+    SECTION("shared result"){
+      AnyReference shared = result;
+      f.call({3, 4}, result);
+      REQUIRE(shared.get<int>() == 5);
+      REQUIRE(result.get<int>() == 7);
+    }
+
+    SECTION("other type"){
+      result = std::string("");
+      f.call({3, 4}, result);
+      REQUIRE(result.type() == getStaticTypeIndex<int>());
+      REQUIRE(result.get<int>() == 7);
+    }
+
+    SECTION("parallel results without default constructor"){
+    struct Value {
+      int value;
+      explicit Value(int v):value(v){ }
+    };
+    AnyFunction g = [](int v){ return Value(v); };
+    AnyFunction h = [](int v){ return v % 2 == 0; };
+    std::vector<int> x(1000);
+    for (size_t i = 0; i < x.size(); ++i) { x[i] = int(i); }
+    for (size_t threads: {1, 3, 4, 999, 2000}) {
+      g.callBatch({std::ref(x)}, result, threads);
+      auto & values = result.get<const std::vector<Value> &>();
+      REQUIRE(values.size() == 1000);
+      for (size_t i = 0; i < values.size(); ++i) { REQUIRE(values[i].value == int(i)); }
+      Any flags;
+      h.callBatch({std::ref(x)}, flags, threads);
+      auto & bools = flags.get<const std::vector<bool> &>();
+      REQUIRE(bools.size() == 1000);
+      for (size_t i = 0; i < bools.size(); ++i) { REQUIRE(bools[i] == (i % 2 == 0)); }
+    }
+  }
+
+  SECTION("void result"){
+      AnyFunction g = [](){};
+      g.call({}, result);
+      REQUIRE(!result);
+    }
+
+    SECTION("referenced result"){
+      int external = 0;
+      result = std::ref(external);
+      f.call({20, 22}, result);
+      REQUIRE(external == 0);
+      REQUIRE(result.get<int>() == 42);
+    }
+  }
+
+  SECTION("typed result"){
+    int result = 0;
+    f.call({1, 2}, result);
+    REQUIRE(result == 3);
+    double converted = 0;
+    f.call({2, 3}, converted);
+    REQUIRE(converted == 5);
+    std::string invalid;
+    REQUIRE_THROWS_AS(f.call({2, 3}, invalid), InvalidVisitorException);
+    REQUIRE_THROWS_AS(f.call({2}, result), AnyFunctionInvalidArgumentCountException);
+    AnyFunction g = [](){};
+    REQUIRE_THROWS_AS(g.call({}, result), UndefinedAnyException);
+  }
+
+  SECTION("undefined function"){
+    int result;
+    REQUIRE_THROWS_AS(AnyFunction().call({}, result), UndefinedAnyFunctionException);
+  }
+}
+
+TEST_CASE("batched call","[any_function]"){
+  AnyFunction f = [](int a, double b){ return a * b; };
+  std::vector<int> a{1, 2, 3};
+  std::vector<double> b{0.5, 1.5, 2.5};
+  Any result;
+
+  SECTION("typed columns"){
+    f.callBatch({std::ref(a), std::ref(b)}, result);
+    REQUIRE(result.get<const std::vector<double> &>() == std::vector<double>{0.5, 3, 7.5});
+    
+    SECTION("reuse result"){
+      auto stored = &result.get<std::vector<double> &>();
+      std::vector<double> c{2, 2, 2};
+      f.callBatch({std::ref(a), std::ref(c)}, result);
+      REQUIRE(&result.get<std::vector<double> &>() == stored);
+      REQUIRE(result.get<const std::vector<double> &>() == std::vector<double>{2, 4, 6});
+    }
+  }
+
+  SECTION("converted columns"){
+    std::vector<int> c{1, 2, 3};
+    std::vector<float> d{0.5f, 1.5f, 2.5f};
+    f.callBatch({std::ref(d), std::ref(c)}, result);
+    REQUIRE(result.get<const std::vector<double> &>() == std::vector<double>{0, 2, 6});
+
+    AnyFunction g = [](const double &a, std::string b){ return b + std::to_string(int(a)); };
+    std::vector<std::string> s{"a", "b", "c"};
+    g.callBatch({std::ref(a), std::ref(s)}, result);
+    REQUIRE(result.get<const std::vector<std::string> &>() == std::vector<std::string>{"a1", "b2", "c3"});
+
+    AnyFunction h = [](double &a){ a = 0; };
+    REQUIRE_THROWS_AS(h.callBatch({std::ref(c)}, result), InvalidVisitorException);
+  }
+
+  SECTION("any columns"){
+    f.callBatch({AnyArguments{1, 2, 3}, std::ref(b)}, result);
+    REQUIRE(result.get<const std::vector<double> &>() == std::vector<double>{0.5, 3, 7.5});
+  }
+
+  SECTION("parallel"){
+    std::vector<int> x(1000);
+    std::vector<double> y(1000, 2);
+    for (size_t i = 0; i < x.size(); ++i) { x[i] = int(i); }
+    f.callBatch({std::ref(x), std::ref(y)}, result, 4);
+    auto & values = result.get<const std::vector<double> &>();
+    REQUIRE(values.size() == 1000);
+    for (size_t i = 0; i < values.size(); ++i) { REQUIRE(values[i] == 2 * i); }
+  }
+
+  SECTION("void result"){
+    int sum = 0;
+    AnyFunction g = [&](int v){ sum += v; };
+    result = 42;
+    g.callBatch({std::ref(a)}, result);
+    REQUIRE(sum == 6);
+    REQUIRE(!result);
+  }
+
+  SECTION("variadic"){
+    AnyFunction g = [](const AnyArguments &args){ return args[0].get<int>() + args[1].get<int>(); };
+    g.callBatch({AnyArguments{1, 2}, AnyArguments{3, 4}}, result, 2);
+    auto & values = result.get<const AnyArguments &>();
+    REQUIRE(values.size() == 2);
+    REQUIRE(values[0].get<int>() == 4);
+    REQUIRE(values[1].get<int>() == 6);
+  }
+
+  SECTION("errors"){
+    std::vector<double> c{1};
+    REQUIRE_THROWS_AS(f.callBatch({std::ref(a), std::ref(c)}, result), AnyFunctionInvalidColumnSizeException);
+    REQUIRE_THROWS_AS(f.callBatch({std::ref(a)}, result), AnyFunctionInvalidArgumentCountException);
+    REQUIRE_THROWS_AS(f.callBatch({std::ref(a), std::string()}, result), InvalidVisitorException);
+    REQUIRE_THROWS_AS(f.callBatch({std::ref(a), AnyArguments{1, "", 3}}, result, 3), InvalidVisitorException);
+    REQUIRE_THROWS_AS(AnyFunction().callBatch({}, result), UndefinedAnyFunctionException);
+  }
+}
+
+TEST_CASE("asynchronous call","[any_function]"){
+  AnyFunction f = [](int a, int b){ return a + b; };
+
+  SECTION("single call"){
+    auto future = f.callAsync({1, 2});
+    REQUIRE(future.valid());
+    REQUIRE(future.get().get<int>() == 3);
+    REQUIRE(future.isReady());
+  }
+
+  SECTION("many calls"){
+    std::vector<AnyFuture> futures;
+    for (int i = 0; i < 100; ++i) { futures.push_back(f.callAsync({i, i})); }
+    for (int i = 0; i < 100; ++i) { REQUIRE(futures[i].get().get<int>() == 2 * i); }
+  }
+
+  SECTION("nested calls"){
+    AnyFunction g = [&](int a){ return f.callAsync({a, 1}).get().get<int>(); };
+    std::vector<AnyFuture> futures;
+    for (int i = 0; i < 100; ++i) { futures.push_back(g.callAsync({i})); }
+    for (int i = 0; i < 100; ++i) { REQUIRE(futures[i].get().get<int>() == i + 1); }
+  }
+
+  SECTION("continuation"){
+    auto future = AnyFuture::create();
+    int result = 0;
+    future.then([&](){ result = future.get().get<int>(); });
+    REQUIRE(result == 0);
+    future.setValue(42);
+    REQUIRE(result == 42);
+  }
+
+  SECTION("multiple continuations"){
+    auto future = AnyFuture::create();
+    std::vector<int> calls;
+    for (int i = 0; i < 11; ++i) { future.then([&, i](){ calls.push_back(i); }); }
+    future.setValue(42);
+    future.then([&](){ calls.push_back(11); });
+    REQUIRE(calls == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11});
+  }
+
+  SECTION("nested calls on a custom pool"){
+    ThreadPool pool(1);
+    AnyFunction g = [&](int a){ return f.callAsync({a, 1}, pool).get().get<int>(); };
+    REQUIRE(g.callAsync({1}, pool).get().get<int>() == 2);
+  }
+
+  SECTION("undefined future"){
+    AnyFuture future;
+    REQUIRE(!future.valid());
+    REQUIRE_THROWS_AS(future.isReady(), UndefinedAnyFutureException);
+    REQUIRE_THROWS_AS(future.get(), UndefinedAnyFutureException);
+    REQUIRE_THROWS_AS(future.then([](){ }), UndefinedAnyFutureException);
+  }
+
+  SECTION("errors"){
+    REQUIRE_THROWS_AS(f.callAsync({1}).get(), AnyFunctionInvalidArgumentCountException);
+    REQUIRE_THROWS_AS(AnyFunction().callAsync({}), UndefinedAnyFunctionException);
+  }
+}
+
 TEST_CASE("call and modify reference arguments","[any_function]"){
   AnyFunction f = [](int &x){ x++; };
   int x = 41;
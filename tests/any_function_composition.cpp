@@ -0,0 +1,124 @@
+#include <catch2/catch.hpp>
+
+#include <lars/any_function_composition.h>
+#include <lars/memoize.h>
+
+using namespace lars;
+
+TEST_CASE("bind", "[any_function_composition]"){
+  AnyFunction f = [](int a, double b, const std::string &c){ return c + std::to_string(a + int(b)); };
+
+  SECTION("leading arguments"){
+    auto g = bind(f, 1, 2.0);
+    REQUIRE(g.argumentCount() == 1);
+    REQUIRE(g.argumentType(0) == getStaticTypeIndex<std::string>());
+    REQUIRE(g.returnType() == getStaticTypeIndex<std::string>());
+    REQUIRE(!g.isVariadic());
+    REQUIRE(g("x").get<std::string>() == "x3");
+    REQUIRE_THROWS_AS(g(), AnyFunctionInvalidArgumentCountException);
+  }
+
+  SECTION("all arguments"){
+    auto g = bind(f, 1, 2, "y");
+    REQUIRE(g.argumentCount() == 0);
+    REQUIRE(g().get<std::string>() == "y3");
+    std::string result;
+    g.call(AnyArguments(), result);
+    REQUIRE(result == "y3");
+  }
+
+  SECTION("captured any"){
+    Any x = 1;
+    auto g = bind(f, x, 0);
+    x.get<int &>() = 5;
+    REQUIRE(g("z").get<std::string>() == "z5");
+  }
+
+  SECTION("variadic"){
+    AnyFunction sum = [](const AnyArguments &args){
+      int s = 0;
+      for (auto &a: args) { s += a.get<int>(); }
+      return s;
+    };
+    auto g = bind(sum, 1, 2);
+    REQUIRE(g.isVariadic());
+    REQUIRE(g(3).get<int>() == 6);
+  }
+
+  SECTION("nested calls"){
+    auto g = bind(f, 1, 2.0);
+    AnyFunction outer = [&](int a, const std::string &s){ return g(s).get<std::string>() + std::to_string(a); };
+    auto h = bind(outer, 4);
+    REQUIRE(h("w").get<std::string>() == "w34");
+    REQUIRE(h("v").get<std::string>() == "v34");
+  }
+
+  SECTION("errors"){
+    REQUIRE_THROWS_AS(bind(f, 1, 2, 3, 4), AnyFunctionInvalidArgumentCountException);
+    REQUIRE_THROWS_AS(bind(AnyFunction(), 1), UndefinedAnyFunctionException);
+  }
+}
+
+TEST_CASE("compose", "[any_function_composition]"){
+  AnyFunction f = [](int a, int b){ return a + b; };
+  AnyFunction g = [](double x){ return x / 2; };
+  AnyFunction h = [](const std::string &s){ return s + "!"; };
+  AnyFunction toString = [](int x){ return std::to_string(x); };
+
+  SECTION("fused"){
+    auto c = compose(f, g);
+    REQUIRE(static_cast<const ComposedAnyFunction &>(*c.getSpecific()).isFused());
+    REQUIRE(c.argumentCount() == 2);
+    REQUIRE(c.argumentType(1) == getStaticTypeIndex<int>());
+    REQUIRE(c.returnType() == getStaticTypeIndex<double>());
+    REQUIRE(c.signature().returnType == getStaticTypeIndex<double>());
+    REQUIRE(c(2, 3).get<double>() == 2.5);
+    double result = 0;
+    c.call({1, 2}, result);
+    REQUIRE(result == 1.5);
+  }
+
+  SECTION("multiple stages"){
+    auto c = compose(f, toString, h, h);
+    REQUIRE(c(1, 2).get<std::string>() == "3!!");
+    REQUIRE(compose(c)(2, 2).get<std::string>() == "4!!");
+  }
+
+  SECTION("composed stages"){
+    auto c = compose(compose(f, toString), h);
+    REQUIRE(static_cast<const ComposedAnyFunction &>(*c.getSpecific()).isFused());
+    REQUIRE(c(1, 2).get<std::string>() == "3!");
+    REQUIRE(compose(f, compose(toString, h))(1, 1).get<std::string>() == "2!");
+  }
+
+  SECTION("memoized stage"){
+    auto c = compose(f, memoize(toString, 4), h);
+    REQUIRE(!static_cast<const ComposedAnyFunction &>(*c.getSpecific()).isFused());
+    REQUIRE(c(1, 2).get<std::string>() == "3!");
+    REQUIRE(c(1, 2).get<std::string>() == "3!");
+  }
+
+  SECTION("any stage"){
+    AnyFunction byReference = [](const Any &x){ return x.get<int>() * 2; };
+    AnyFunction byValue = [](Any x){ return x.get<int>() + 1; };
+    AnyFunction shared = [](std::shared_ptr<int> x){ return *x; };
+    auto c = compose(f, byReference, byValue);
+    REQUIRE(!static_cast<const ComposedAnyFunction &>(*c.getSpecific()).isFused());
+    REQUIRE(c(1, 2).get<int>() == 7);
+    REQUIRE(compose(g, byValue)(4.0).get<int>() == 3);
+    REQUIRE(compose(f, shared)(1, 2).get<int>() == 3);
+  }
+
+  SECTION("void stage"){
+    AnyFunction v = [](int){ };
+    REQUIRE(!compose(f, v)(1, 2));
+    REQUIRE_THROWS_AS(compose(v, g)(1), UndefinedAnyException);
+  }
+
+  SECTION("errors"){
+    REQUIRE_THROWS_AS(compose(g, f), AnyFunctionInvalidArgumentCountException);
+    REQUIRE_THROWS_AS(compose(f, AnyFunction()), UndefinedAnyFunctionException);
+    REQUIRE_THROWS_AS(compose(f, h)(1, 2), InvalidVisitorException);
+    REQUIRE_THROWS_AS(compose(f, g)(1), AnyFunctionInvalidArgumentCountException);
+  }
+}
@@ -0,0 +1,175 @@
+#include <catch2/catch.hpp>
+
+#include <lars/any_function.h>
+#include <lars/any_serializer.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace lars;
+
+namespace {
+  struct Point {
+    float x, y;
+  };
+
+  struct Named {
+    std::string name;
+  };
+
+  template <typename ... Args> std::vector<Any> values(Args && ... args) {
+    std::vector<Any> result;
+    (result.emplace_back(std::forward<Args>(args)), ...);
+    return result;
+  }
+
+  /**
+   * Copies `data` to a buffer aligned to 8 bytes, starting at `offset`.
+   */
+  struct AlignedBuffer {
+    std::vector<uint64_t> storage;
+    std::string_view view;
+
+    AlignedBuffer(const std::string &data, size_t offset = 0):storage((data.size() + offset) / sizeof(uint64_t) + 1){
+      auto begin = reinterpret_cast<char *>(storage.data()) + offset;
+      std::memcpy(begin, data.data(), data.size());
+      view = std::string_view(begin, data.size());
+    }
+  };
+}
+
+TEST_CASE("AnySerializer", "[any_serializer]"){
+  AnySerializer serializer;
+
+  SECTION("built-in types"){
+    std::vector<Any> input;
+    input.emplace_back(char('c'));
+    input.emplace_back(int(-1));
+    input.emplace_back(long(2));
+    input.emplace_back((long long)(3));
+    input.emplace_back((unsigned char)(4));
+    input.emplace_back(5u);
+    input.emplace_back(6ul);
+    input.emplace_back(7ull);
+    input.emplace_back(8.5f);
+    input.emplace_back(9.5);
+    input.emplace_back((long double)(10.5));
+    input.emplace_back(std::string("string"));
+    input.emplace_back(Any());
+
+    AlignedBuffer buffer(serializer.serialize(input));
+    auto result = serializer.deserialize(buffer.view);
+    REQUIRE(result.size() == input.size());
+    REQUIRE(result[0].get<char>() == 'c');
+    REQUIRE(result[1].get<int>() == -1);
+    REQUIRE(result[2].get<long>() == 2);
+    REQUIRE(result[3].get<long long>() == 3);
+    REQUIRE(result[4].get<unsigned char>() == 4);
+    REQUIRE(result[5].get<unsigned>() == 5);
+    REQUIRE(result[6].get<unsigned long>() == 6);
+    REQUIRE(result[7].get<unsigned long long>() == 7);
+    REQUIRE(result[8].get<float>() == 8.5);
+    REQUIRE(result[9].get<double>() == 9.5);
+    REQUIRE(result[10].get<long double>() == 10.5);
+    REQUIRE(result[11].get<std::string>() == "string");
+    REQUIRE(!result[12]);
+    for (size_t i = 0; i < 11; ++i) {
+      REQUIRE(result[i].type() == input[i].type());
+    }
+    REQUIRE(result[11].type() == getStaticTypeIndex<std::string>());
+  }
+
+  SECTION("decoded strings"){
+    AlignedBuffer buffer(serializer.serialize(values(std::string("string"))));
+    auto result = serializer.deserialize(buffer.view);
+    REQUIRE(result[0].get<const std::string &>() == "string");
+    AnyFunction length = [](const std::string &value){ return value.size(); };
+    REQUIRE(length(result[0]).get<size_t>() == 6);
+  }
+
+  SECTION("numeric conversions"){
+    AlignedBuffer buffer(serializer.serialize(values(42)));
+    auto result = serializer.deserialize(buffer.view);
+    REQUIRE(result[0].get<double>() == 42);
+    REQUIRE(result[0].get<unsigned char>() == 42);
+  }
+
+  SECTION("zero-copy reads"){
+    serializer.setStringViews(true);
+    AlignedBuffer buffer(serializer.serialize(values(1.5, std::string("string"))));
+    auto result = serializer.deserialize(buffer.view);
+    auto begin = buffer.view.data(), end = begin + buffer.view.size();
+    auto number = &result[0].get<const double &>();
+    REQUIRE(reinterpret_cast<const char *>(number) >= begin);
+    REQUIRE(reinterpret_cast<const char *>(number) < end);
+    auto string = result[1].get<std::string_view>();
+    REQUIRE(string == "string");
+    REQUIRE(string.data() >= begin);
+    REQUIRE(string.data() < end);
+    REQUIRE(result[1].type() == getStaticTypeIndex<std::string_view>());
+  }
+
+  SECTION("unaligned buffers are copied"){
+    AlignedBuffer buffer(serializer.serialize(values(1.5)), 1);
+    auto result = serializer.deserialize(buffer.view);
+    REQUIRE(result[0].get<double>() == 1.5);
+    auto number = reinterpret_cast<const char *>(&result[0].get<const double &>());
+    REQUIRE((number < buffer.view.data() || number >= buffer.view.data() + buffer.view.size()));
+  }
+
+  SECTION("decoded values can be serialized again"){
+    AlignedBuffer buffer(serializer.serialize(values(1.5, std::string("string"))));
+    auto data = serializer.serialize(serializer.deserialize(buffer.view));
+    REQUIRE(data == std::string(buffer.view));
+    serializer.setStringViews(true);
+    REQUIRE(serializer.serialize(serializer.deserialize(buffer.view)) == data);
+  }
+
+  SECTION("single entries"){
+    std::string data;
+    serializer.write(Any(1), data);
+    serializer.write(Any(std::string("abc")), data);
+    REQUIRE(data.size() % 8 == 0);
+    AlignedBuffer buffer(data);
+    size_t offset = 0;
+    REQUIRE(serializer.read(buffer.view, offset).get<int>() == 1);
+    REQUIRE(serializer.read(buffer.view, offset).get<std::string>() == "abc");
+    REQUIRE(offset == data.size());
+  }
+
+  SECTION("user types"){
+    REQUIRE(!serializer.supports<Point>());
+    REQUIRE_THROWS_AS(serializer.serialize(values(Point{1, 2})), AnySerializationException);
+
+    serializer.addTrivial<Point>();
+    serializer.add<Named>(
+      [](const Named &value, std::string &out){ out.append(value.name); },
+      [](std::string_view payload){ return Any(Named{std::string(payload)}); }
+    );
+    REQUIRE(serializer.supports<Point>());
+
+    AlignedBuffer buffer(serializer.serialize(values(Point{1, 2}, Named{"name"})));
+    auto result = serializer.deserialize(buffer.view);
+    REQUIRE(result[0].get<const Point &>().x == 1);
+    REQUIRE(result[0].get<const Point &>().y == 2);
+    REQUIRE(result[1].get<const Named &>().name == "name");
+
+    AnySerializer other;
+    REQUIRE_THROWS_AS(other.deserialize(buffer.view), AnySerializationException);
+  }
+
+  SECTION("invalid buffers"){
+    auto data = serializer.serialize(values(1, std::string("string")));
+    REQUIRE_THROWS_AS(serializer.deserialize(""), AnySerializationException);
+    REQUIRE_THROWS_AS(serializer.deserialize(std::string_view(data).substr(0, data.size() - 8)), AnySerializationException);
+    auto invalid = data;
+    invalid[0] = 'X';
+    REQUIRE_THROWS_AS(serializer.deserialize(invalid), AnySerializationException);
+    invalid = data;
+    invalid[8] = 100;
+    REQUIRE_THROWS_AS(serializer.deserialize(invalid), AnySerializationException);
+  }
+
+}
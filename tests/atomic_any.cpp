@@ -0,0 +1,120 @@
+#include <catch2/catch.hpp>
+
+#include <lars/atomic_any.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lars;
+
+namespace {
+  struct Counted {
+    static std::atomic<int> live;
+    int value;
+    Counted(int v):value(v){ ++live; }
+    Counted(const Counted &other):value(other.value){ ++live; }
+    ~Counted(){ --live; }
+  };
+
+  std::atomic<int> Counted::live{0};
+}
+
+TEST_CASE("AtomicAny", "[atomic_any]"){
+
+  SECTION("load and store"){
+    AtomicAny value;
+    REQUIRE(!value.load());
+    value.store(42);
+    REQUIRE(value.load().get<int>() == 42);
+    value.store(std::string("string"));
+    REQUIRE(value.load().get<std::string>() == "string");
+    REQUIRE(value.read([](const Any &v){ return v.get<std::string>().size(); }) == 6);
+  }
+
+  SECTION("exchange"){
+    AtomicAny value(Any(1));
+    REQUIRE(value.exchange(2).get<int>() == 1);
+    REQUIRE(value.load().get<int>() == 2);
+  }
+
+  SECTION("compare exchange"){
+    AtomicAny value(Any(1));
+    auto expected = value.load();
+    REQUIRE(value.compareExchange(expected, 2));
+    REQUIRE(value.load().get<int>() == 2);
+    REQUIRE(expected.get<int>() == 1);
+
+    REQUIRE(!value.compareExchange(expected, 3));
+    REQUIRE(expected.get<int>() == 2);
+    REQUIRE(value.load().get<int>() == 2);
+
+    AnyReference other = Any(2);
+    REQUIRE(!value.compareExchange(other, 3));
+  }
+
+  SECTION("loaded values outlive stores"){
+    REQUIRE(Counted::live == 0);
+    {
+      AtomicAny value(Any(Counted(1)));
+      auto loaded = value.load();
+      value.store(Counted(2));
+      REQUIRE(loaded.get<const Counted &>().value == 1);
+      REQUIRE(Counted::live == 2);
+      loaded.reset();
+      REQUIRE(Counted::live == 1);
+      value.store(Counted(3));
+      REQUIRE(Counted::live == 1);
+    }
+    REQUIRE(Counted::live == 0);
+  }
+
+  SECTION("concurrent readers and writers"){
+    constexpr int readers = 4, writers = 2, stores = 500;
+    AtomicAny value(Any(std::string(64, 'a')));
+    std::atomic<bool> stop{false};
+    std::atomic<bool> valid{true};
+
+    auto uniform = [](const std::string &s){
+      return s.size() == 64 && s.find_first_not_of(s[0]) == std::string::npos;
+    };
+
+    std::vector<std::thread> threads;
+    for (int r = 0; r < readers; ++r) {
+      threads.emplace_back([&, r](){
+        while (!stop) {
+          if (r % 2) {
+            if (!uniform(value.load().get<const std::string &>())) { valid = false; }
+          } else {
+            value.read([&](const Any &v){ if (!uniform(v.get<const std::string &>())) { valid = false; } });
+          }
+        }
+      });
+    }
+
+    std::atomic<int> swaps{0};
+    std::vector<std::thread> writerThreads;
+    for (int w = 0; w < writers; ++w) {
+      writerThreads.emplace_back([&, w](){
+        for (int i = 0; i < stores; ++i) {
+          auto c = char('a' + (w * stores + i) % 26);
+          if (i % 2) {
+            value.store(std::string(64, c));
+          } else {
+            auto expected = value.load();
+            if (value.compareExchange(expected, std::string(64, c))) { ++swaps; }
+          }
+        }
+      });
+    }
+    for (auto &thread: writerThreads) { thread.join(); }
+    stop = true;
+    for (auto &thread: threads) { thread.join(); }
+
+    REQUIRE(valid);
+    REQUIRE(swaps > 0);
+    REQUIRE(uniform(value.load().get<const std::string &>()));
+  }
+
+}
@@ -0,0 +1,204 @@
+#include <catch2/catch.hpp>
+
+#include <lars/bi_visitor.h>
+#include <lars/memoize.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+  using namespace lars;
+
+  struct Object: public Visitable<Object> {
+    char name = 'O';
+  };
+
+  struct Ship: public DerivedVisitable<Ship, Object> {
+    int hits = 0;
+  };
+
+  struct Asteroid: public DerivedVisitable<Asteroid, VirtualVisitable<Object>> {
+    char size = 'L';
+  };
+
+  struct SmallAsteroid: public DerivedVisitable<SmallAsteroid, Asteroid> {
+    SmallAsteroid(){ size = 'S'; }
+  };
+
+  struct Other: public Visitable<Other> {
+  };
+
+  struct Point {
+    int x = 0;
+  };
+
+  struct PointVisitor: public BiVisitor<
+    TypeList<Point &, const Point &>,
+    TypeList<const Point &, const Point &>
+  > {
+    std::string result;
+
+    void visit(Point &a, const Point &) override {
+      a.x = 42;
+      result += "M";
+    }
+
+    void visit(const Point &, const Point &) override {
+      result += "C";
+    }
+  };
+
+  struct CollisionVisitor: public BiVisitor<
+    TypeList<Ship &, const Asteroid &>,
+    TypeList<const Asteroid &, const Asteroid &>,
+    TypeList<const Object &, const Object &>
+  > {
+    std::string result;
+
+    void visit(Ship &ship, const Asteroid &asteroid) override {
+      ++ship.hits;
+      result += std::string("SA") + asteroid.size;
+    }
+
+    void visit(const Asteroid &a, const Asteroid &b) override {
+      result += std::string("AA") + a.size + b.size;
+    }
+
+    void visit(const Object &, const Object &) override {
+      result += "OO";
+    }
+  };
+}
+
+TEST_CASE("BiVisitor", "[bi_visitor]"){
+  Ship ship;
+  Asteroid asteroid;
+  SmallAsteroid small;
+  Object object;
+  Other other;
+  CollisionVisitor visitor;
+
+  SECTION("pairs"){
+    visit2(ship, asteroid, visitor);
+    visit2(ship, small, visitor);
+    visit2(small, asteroid, visitor);
+    REQUIRE(visitor.result == "SALSASAASL");
+    REQUIRE(ship.hits == 2);
+  }
+
+  SECTION("base class fallback"){
+    visit2(asteroid, ship, visitor);
+    visit2(object, small, visitor);
+    visit2(ship, ship, visitor);
+    REQUIRE(visitor.result == "OOOOOO");
+  }
+
+  SECTION("const objects"){
+    const Ship &constShip = ship;
+    visit2(constShip, asteroid, visitor);
+    REQUIRE(visitor.result == "OO");
+    REQUIRE(ship.hits == 0);
+  }
+
+  SECTION("cached resolution"){
+    for (int i = 0; i < 100; ++i) {
+      visit2(ship, small, visitor);
+      visit2(small, small, visitor);
+    }
+    REQUIRE(ship.hits == 100);
+    REQUIRE(visitor.result.size() == 100 * 7);
+  }
+
+  SECTION("no match"){
+    REQUIRE_THROWS_AS(visit2(other, ship, visitor), InvalidVisitorException);
+    REQUIRE_THROWS_AS(visit2(ship, other, visitor), InvalidVisitorException);
+  }
+
+  SECTION("default"){
+    struct DefaultVisitor: public CollisionVisitor {
+      void visitDefault(const VisitableBase &, const VisitableBase &) override {
+        result += "?";
+      }
+    } defaultVisitor;
+    visit2(other, ship, defaultVisitor);
+    visit2(ship, asteroid, defaultVisitor);
+    REQUIRE(defaultVisitor.result == "?SAL");
+  }
+
+  SECTION("concurrent visits"){
+    struct CountingVisitor: public BiVisitor<
+      TypeList<const Asteroid &, const Asteroid &>,
+      TypeList<const Object &, const Object &>
+    > {
+      std::atomic<int> &asteroids, &objects;
+      CountingVisitor(std::atomic<int> &a, std::atomic<int> &o):asteroids(a),objects(o){ }
+      void visit(const Asteroid &, const Asteroid &) override { ++asteroids; }
+      void visit(const Object &, const Object &) override { ++objects; }
+    };
+
+    std::atomic<int> asteroids{0}, objects{0};
+    CountingVisitor shared(asteroids, objects);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+      threads.emplace_back([&, t](){
+        CountingVisitor own(asteroids, objects);
+        auto &v = t % 2 ? static_cast<CountingVisitor &>(own) : shared;
+        for (int i = 0; i < 1000; ++i) {
+          visit2(small, asteroid, v);
+          visit2(asteroid, ship, v);
+          visit2(object, object, v);
+        }
+      });
+    }
+    for (auto &thread: threads) { thread.join(); }
+    REQUIRE(asteroids == 8 * 1000);
+    REQUIRE(objects == 8 * 2000);
+  }
+}
+
+TEST_CASE("BiVisitor with Any", "[bi_visitor]"){
+  PointVisitor visitor;
+  Any other = Point();
+
+  SECTION("values"){
+    Any value = Point();
+    visit2(value, other, visitor);
+    REQUIRE(value.get<const Point &>().x == 42);
+    visit2(std::as_const(value), std::as_const(other), visitor);
+    REQUIRE(visitor.result == "MC");
+  }
+
+  SECTION("references"){
+    Point point;
+    Any reference = std::ref(point);
+    visit2(reference, other, visitor);
+    REQUIRE(point.x == 42);
+    REQUIRE(visitor.result == "M");
+  }
+
+  SECTION("const references"){
+    Point point;
+    Any reference = std::cref(point);
+    REQUIRE_THROWS_AS(reference.get<Point &>(), InvalidVisitorException);
+    visit2(reference, other, visitor);
+    REQUIRE(point.x == 0);
+    REQUIRE(visitor.result == "C");
+  }
+
+  SECTION("memoized results"){
+    AnyFunction f = [](int x){ Point point; point.x = x; return point; };
+    auto g = memoize(f, 1);
+    auto result = g(1);
+    visit2(result, other, visitor);
+    REQUIRE(visitor.result == "M");
+    REQUIRE(result.get<const Point &>().x == 42);
+    REQUIRE(g(1).get<const Point &>().x == 1);
+  }
+
+  SECTION("undefined"){
+    Any empty;
+    REQUIRE_THROWS_AS(visit2(empty, other, visitor), UndefinedAnyException);
+  }
+}
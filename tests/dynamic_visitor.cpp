@@ -0,0 +1,175 @@
+#include <catch2/catch.hpp>
+
+#include <lars/any.h>
+#include <lars/dynamic_visitor.h>
+
+#include <functional>
+#include <string>
+
+namespace {
+  using namespace lars;
+
+  struct A: Visitable<A> {
+    char name = 'A';
+  };
+
+  struct B: DerivedVisitable<B, A> {
+    char name = 'B';
+  };
+
+  struct X: Visitable<X> {
+  };
+}
+
+TEST_CASE("DynamicVisitor", "[dynamic_visitor]"){
+  A a;
+  B b;
+  X x;
+  std::string result;
+
+  DynamicVisitor visitor;
+  visitor.add<A &>([&](A &v){ result += v.name; });
+  REQUIRE(visitor.handles<A &>());
+  REQUIRE(!visitor.handles<B &>());
+  REQUIRE(visitor.size() == 1);
+
+  a.accept(visitor);
+  REQUIRE(result == "A");
+  b.accept(visitor);
+  REQUIRE(result == "AA");
+  REQUIRE_THROWS_AS(x.accept(visitor), InvalidVisitorException);
+  REQUIRE_THROWS_WITH(x.accept(visitor), Catch::Contains("Expected types: ") && Catch::Contains("A&"));
+
+  SECTION("derived handler is preferred"){
+    visitor.add<B &>([&](B &v){ result += v.name; });
+    result.clear();
+    a.accept(visitor);
+    b.accept(visitor);
+    REQUIRE(result == "AB");
+  }
+
+  SECTION("const visitables"){
+    const A &ca = a;
+    REQUIRE_THROWS_AS(ca.accept(visitor), InvalidVisitorException);
+    visitor.add<const A &>([&](const A &){ result += 'c'; });
+    result.clear();
+    ca.accept(visitor);
+    REQUIRE(result == "c");
+  }
+
+  SECTION("composition"){
+    DynamicVisitor plugin;
+    plugin.add<A &>([&](A &){ result += '1'; });
+    plugin.add<X &>([&](X &){ result += 'X'; });
+
+    DynamicVisitor composed;
+    composed.add(visitor).add(plugin);
+    REQUIRE(composed.size() == 2);
+
+    result.clear();
+    a.accept(composed);
+    x.accept(composed);
+    REQUIRE(result == "A1X");
+
+    visitor.add<A &>([&](A &){ result += '2'; });
+    result.clear();
+    a.accept(composed);
+    REQUIRE(result == "A1");
+
+    DynamicVisitor copy = composed;
+    result.clear();
+    b.accept(copy);
+    REQUIRE(result == "A1");
+  }
+
+  SECTION("composed plugins use their own first match"){
+    DynamicVisitor derived, base;
+    derived.add<B &>([&](B &){ result += "1B"; });
+    base.add<A &>([&](A &){ result += "2A"; });
+
+    result.clear();
+    b.accept(derived);
+    b.accept(base);
+    REQUIRE(result == "1B2A");
+
+    DynamicVisitor composed;
+    composed.add(derived).add(base);
+    REQUIRE(composed.handles<B &>());
+    REQUIRE(composed.handles<A &>());
+    result.clear();
+    b.accept(composed);
+    REQUIRE(result == "1B2A");
+    result.clear();
+    a.accept(composed);
+    REQUIRE(result == "2A");
+    REQUIRE_THROWS_WITH(x.accept(composed), Catch::Contains("A&") && Catch::Contains("B&"));
+
+    const B &cb = b;
+    REQUIRE_THROWS_AS(cb.accept(composed), InvalidVisitorException);
+    DynamicVisitor constBase;
+    constBase.add<const A &>([&](const A &){ result += "3A"; });
+    composed.add(constBase);
+    result.clear();
+    b.accept(composed);
+    cb.accept(composed);
+    REQUIRE(result == "1B2A3A3A");
+
+    DynamicVisitor nested;
+    nested.add<B &>([&](B &){ result += "0B"; });
+    nested.add(composed);
+    nested.freeze();
+    REQUIRE_THROWS_AS(nested.add(base), FrozenTypeMapException);
+    result.clear();
+    b.accept(nested);
+    REQUIRE(result == "0B1B2A3A");
+  }
+
+  SECTION("composed plugins visited from handlers"){
+    DynamicVisitor derived, base, composed;
+    derived.add<B &>([&](B &){
+      result += '1';
+      a.accept(composed);
+    });
+    base.add<A &>([&](A &v){ result += &v == &a ? 'a' : 'b'; });
+    composed.add(derived).add(base);
+    result.clear();
+    b.accept(composed);
+    REQUIRE(result == "1ab");
+  }
+
+  SECTION("composed plugins with Any values"){
+    DynamicVisitor increment, ints, doubles, composed;
+    increment.add<int &>([](int &v){ ++v; });
+    ints.add<const int &>([&](const int &v){ result += std::to_string(v); });
+    doubles.add<double>([&](double v){ result += v == 2.0 ? 'd' : '?'; });
+    composed.add(increment).add(ints).add(doubles);
+
+    Any value = 1;
+    result.clear();
+    value.accept(composed);
+    REQUIRE(result == "2d");
+    REQUIRE(value.get<int>() == 2);
+
+    const Any &constValue = value;
+    result.clear();
+    constValue.accept(composed);
+    REQUIRE(result == "2d");
+    REQUIRE(value.get<int>() == 2);
+
+    int v = 2;
+    Any reference = std::cref(v);
+    result.clear();
+    reference.accept(composed);
+    REQUIRE(result == "2d");
+    REQUIRE(v == 2);
+  }
+
+  SECTION("frozen"){
+    visitor.freeze();
+    result.clear();
+    a.accept(visitor);
+    REQUIRE(result == "A");
+    REQUIRE_THROWS_AS(visitor.add<B &>([](B &){}), FrozenTypeMapException);
+    REQUIRE_THROWS_AS(visitor.add<A &>([](A &){}), FrozenTypeMapException);
+  }
+}
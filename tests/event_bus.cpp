@@ -0,0 +1,210 @@
+#include <catch2/catch.hpp>
+
+#include <lars/atomic_any.h>
+#include <lars/event_bus.h>
+
+#include <atomic>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace lars;
+
+namespace {
+  struct A: public Visitable<A> { int value = 0; };
+  struct B: public DerivedVisitable<B, A> { };
+  struct X: public Visitable<X> { };
+
+  struct Thrower {
+    static int instances;
+    static int copiesUntilThrow;
+    int value;
+    explicit Thrower(int v):value(v){ ++instances; }
+    Thrower(const Thrower &other):value(other.value){
+      if (copiesUntilThrow >= 0 && copiesUntilThrow-- == 0) { throw std::runtime_error("copy failed"); }
+      ++instances;
+    }
+    ~Thrower(){ --instances; }
+  };
+  int Thrower::instances = 0;
+  int Thrower::copiesUntilThrow = -1;
+
+  Any makeA(int value) {
+    Any result = A();
+    result.get<A &>().value = value;
+    return result;
+  }
+}
+
+TEST_CASE("EventBus", "[event_bus]"){
+  EventBus bus;
+
+  SECTION("routing by type"){
+    std::vector<int> ints;
+    std::vector<std::string> strings;
+    auto intSubscriber = bus.subscribe<const int &>([&](const int &v){ ints.push_back(v); });
+    auto stringSubscriber = bus.subscribe<const std::string &>([&](const std::string &v){ strings.push_back(v); });
+
+    bus.publish(Any(1));
+    bus.publish(Any(std::string("a")));
+    bus.publish(Any(2));
+    bus.publish(Any(X()));
+
+    REQUIRE(intSubscriber->poll() == 2);
+    REQUIRE(stringSubscriber->poll() == 1);
+    REQUIRE(ints == std::vector<int>{1, 2});
+    REQUIRE(strings == std::vector<std::string>{"a"});
+    REQUIRE(intSubscriber->empty());
+  }
+
+  SECTION("base types"){
+    std::vector<std::string> calls;
+    auto baseSubscriber = bus.subscribe<const A &>([&](const A &){ calls.push_back("base"); });
+    DynamicVisitor handlers;
+    handlers.add<const A &>([&](const A &){ calls.push_back("A"); });
+    handlers.add<const B &>([&](const B &){ calls.push_back("B"); });
+    auto subscriber = bus.subscribe(std::move(handlers));
+
+    bus.publish(Any(B()));
+    bus.publish(Any(A()));
+    baseSubscriber->poll();
+    subscriber->poll();
+    REQUIRE(calls == std::vector<std::string>{"base", "base", "B", "A"});
+  }
+
+  SECTION("subscription changes"){
+    int count = 0;
+    bus.publish(Any(1));
+    auto subscriber = bus.subscribe<const int &>([&](const int &){ ++count; });
+    bus.publish(Any(1));
+    REQUIRE(subscriber->poll() == 1);
+
+    bus.unsubscribe(subscriber);
+    bus.publish(Any(1));
+    REQUIRE(subscriber->poll() == 0);
+    REQUIRE(count == 1);
+  }
+
+  SECTION("subscription changes keep resolved routes"){
+    std::string calls;
+    bus.publish(Any(B()));
+    bus.publish(Any(1));
+    auto first = bus.subscribe<const A &>([&](const A &){ calls += "1"; });
+    auto second = bus.subscribe<const B &>([&](const B &){ calls += "2"; });
+    auto third = bus.subscribe<const X &>([&](const X &){ calls += "3"; });
+    bus.publish(Any(B()));
+    bus.publish(Any(1));
+    first->poll();
+    second->poll();
+    REQUIRE(third->empty());
+    REQUIRE(calls == "12");
+
+    bus.unsubscribe(first);
+    bus.publish(Any(B()));
+    REQUIRE(first->poll() == 0);
+    REQUIRE(second->poll() == 1);
+    REQUIRE(calls == "122");
+  }
+
+  SECTION("publishing while reading an AtomicAny"){
+    AtomicAny value(1);
+    int count = 0;
+    value.read([&](const Any &){
+      auto subscriber = bus.subscribe<const int &>([&](const int &){ ++count; });
+      bus.publish(Any(1));
+      bus.publish(Any(A()));
+      bus.unsubscribe(subscriber);
+      return subscriber->poll();
+    });
+    REQUIRE(count == 1);
+  }
+
+  SECTION("polling in batches"){
+    int sum = 0;
+    auto subscriber = bus.subscribe<const A &>([&](const A &a){ sum += a.value; });
+    for (int i = 1; i <= 10; ++i) { bus.publish(makeA(i)); }
+    REQUIRE(subscriber->poll(4) == 4);
+    REQUIRE(sum == 10);
+    REQUIRE(subscriber->poll() == 6);
+    REQUIRE(sum == 55);
+  }
+
+  SECTION("batch publishing"){
+    std::vector<int> ints;
+    int strings = 0;
+    auto intSubscriber = bus.subscribe<const int &>([&](const int &v){ ints.push_back(v); });
+    auto stringSubscriber = bus.subscribe<const std::string &>([&](const std::string &){ ++strings; });
+
+    std::vector<Any> values;
+    for (int i = 0; i < 10; ++i) {
+      values.emplace_back(i);
+      values.emplace_back(std::to_string(i));
+    }
+    values.emplace_back(X());
+    bus.publish(values.begin(), values.end());
+
+    REQUIRE(intSubscriber->poll() == 10);
+    REQUIRE(stringSubscriber->poll() == 10);
+    REQUIRE(ints == std::vector<int>{0, 1, 2, 3, 4, 5, 6, 7, 8, 9});
+  }
+
+  SECTION("empty values"){
+    auto subscriber = bus.subscribe<const int &>([](const int &){ });
+    REQUIRE_THROWS_AS(bus.publish(Any()), UndefinedAnyException);
+    std::vector<Any> values;
+    values.emplace_back(1);
+    values.emplace_back();
+    REQUIRE_THROWS_AS(bus.publish(values.begin(), values.end()), UndefinedAnyException);
+    REQUIRE(subscriber->poll() == 1);
+  }
+
+  SECTION("throwing copies"){
+    std::vector<int> received;
+    {
+      auto first = bus.subscribe<const Thrower &>([&](const Thrower &v){ received.push_back(v.value); });
+      auto second = bus.subscribe<const Thrower &>([&](const Thrower &){ });
+      std::vector<Thrower> values;
+      for (int i = 0; i < 4; ++i) { values.emplace_back(i); }
+      bus.publish(Any(Thrower(-1)));
+      Thrower::copiesUntilThrow = 2;
+      REQUIRE_THROWS_AS(bus.publish(values.begin(), values.end()), std::runtime_error);
+      Thrower::copiesUntilThrow = -1;
+      REQUIRE(first->poll() == 3);
+      REQUIRE(second->poll() == 3);
+      REQUIRE(received == std::vector<int>{-1, 0, 1});
+      bus.publish(values.begin(), values.end());
+      REQUIRE(first->poll() == 4);
+      REQUIRE(second->poll() == 4);
+    }
+    REQUIRE(Thrower::instances == 0);
+  }
+
+  SECTION("concurrent publishers"){
+    constexpr int publishers = 4, count = 5000;
+    long long sum = 0;
+    int received = 0;
+    auto subscriber = bus.subscribe<const int &>([&](const int &v){ sum += v; ++received; });
+    std::atomic<int> done{0};
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < publishers; ++p) {
+      threads.emplace_back([&](){
+        for (int i = 0; i < count; ++i) {
+          bus.publish(Any(i));
+          if (i % 100 == 0) { bus.publish(Any(std::string("ignored"))); }
+        }
+        ++done;
+      });
+    }
+    std::thread consumer([&](){
+      while (done < publishers || !subscriber->empty()) { subscriber->poll(64); }
+    });
+    for (auto &thread: threads) { thread.join(); }
+    consumer.join();
+
+    REQUIRE(received == publishers * count);
+    REQUIRE(sum == publishers * (long long)(count) * (count - 1) / 2);
+  }
+
+}
@@ -0,0 +1,77 @@
+#include <catch2/catch.hpp>
+
+#include <lars/function_registry.h>
+#include <thread>
+
+using namespace lars;
+
+TEST_CASE("FunctionRegistry", "[function_registry]"){
+  FunctionRegistry registry;
+  auto add = registry.add("add", [](int a, int b){ return a + b; });
+  auto greet = registry.add("greet", [](const std::string &name){ return "Hello " + name + "!"; });
+
+  REQUIRE(add != greet);
+  REQUIRE(registry.size() == 2);
+  REQUIRE_THROWS_AS(registry.add("add", [](){}), InvalidFunctionRegistrationException);
+
+  auto check = [&](){
+    REQUIRE(registry.find("add") == add);
+    REQUIRE(registry.find("greet") == greet);
+    REQUIRE(!registry.find("missing"));
+    REQUIRE(!registry.find(""));
+    REQUIRE_THROWS_AS(registry.handle("missing"), UnknownFunctionException);
+    REQUIRE_THROWS_WITH(registry.get("missing"), Catch::Matchers::Contains("missing"));
+    REQUIRE_THROWS_AS(registry.get(FunctionHandle()), UnknownFunctionException);
+    REQUIRE(registry.name(add) == "add");
+    REQUIRE(registry(add, 1, 2).get<int>() == 3);
+    REQUIRE(registry("greet", "registry").get<std::string>() == "Hello registry!");
+    REQUIRE(registry.signature(add).returnType == getStaticTypeIndex<int>());
+    REQUIRE(registry.signature(greet).argumentCount == 1);
+    REQUIRE(registry.signature(greet).argumentTypes[0] == getStaticTypeIndex<std::string>());
+  };
+
+  SECTION("mutable"){
+    REQUIRE(!registry.isFrozen());
+    check();
+  }
+
+  SECTION("frozen"){
+    registry.freeze();
+    REQUIRE(registry.isFrozen());
+    check();
+    REQUIRE_THROWS_AS(registry.add("other", [](){}), InvalidFunctionRegistrationException);
+    REQUIRE_NOTHROW(registry.freeze());
+  }
+}
+
+TEST_CASE("FunctionRegistry perfect hash", "[function_registry]"){
+  FunctionRegistry registry;
+  const size_t count = 5000;
+  std::vector<FunctionHandle> handles;
+  for (size_t i = 0; i < count; ++i) {
+    handles.push_back(registry.add("function" + std::to_string(i), [i](){ return i; }));
+  }
+  registry.freeze();
+
+  std::vector<std::thread> threads;
+  std::atomic<size_t> errors{0};
+  for (size_t t = 0; t < 4; ++t) {
+    threads.emplace_back([&](){
+      for (size_t i = 0; i < count; ++i) {
+        auto name = "function" + std::to_string(i);
+        if (registry.find(name) != handles[i]) { ++errors; }
+        if (registry.find(name + "x")) { ++errors; }
+        if (registry.get(handles[i])().get<size_t>() != i) { ++errors; }
+      }
+    });
+  }
+  for (auto &thread: threads) { thread.join(); }
+  REQUIRE(errors == 0);
+}
+
+TEST_CASE("empty FunctionRegistry", "[function_registry]"){
+  FunctionRegistry registry;
+  registry.freeze();
+  REQUIRE(registry.size() == 0);
+  REQUIRE(!registry.find("any"));
+}
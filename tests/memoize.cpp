@@ -0,0 +1,99 @@
+#include <catch2/catch.hpp>
+
+#include <lars/memoize.h>
+#include <atomic>
+
+using namespace lars;
+
+TEST_CASE("memoize", "[memoize]"){
+  std::atomic<int> calls{0};
+  AnyFunction f = [&](int a, const std::string &b){ ++calls; return b + std::to_string(a); };
+  auto g = memoize(f, 2);
+
+  REQUIRE(g.returnType() == getStaticTypeIndex<std::string>());
+  REQUIRE(g.argumentCount() == 2);
+  REQUIRE(g.argumentType(1) == getStaticTypeIndex<std::string>());
+  REQUIRE(&g.signature() == &f.signature());
+  REQUIRE(!g.isVariadic());
+
+  SECTION("cached results"){
+    REQUIRE(g(1, "a").get<std::string>() == "a1");
+    REQUIRE(g(1, "a").get<std::string>() == "a1");
+    REQUIRE(calls == 1);
+    REQUIRE(g(2, "a").get<std::string>() == "a2");
+    REQUIRE(g(1, "b").get<std::string>() == "b1");
+    REQUIRE(calls == 3);
+  }
+
+  SECTION("results are copies"){
+    auto result = g(1, "a");
+    result.get<std::string &>() = "modified";
+    REQUIRE(g(1, "a").get<std::string>() == "a1");
+    auto cached = g(1, "a");
+    cached.get<std::string &>() += "!";
+    REQUIRE(cached.get<std::string>() == "a1!");
+    REQUIRE(g(1, "a").get<std::string>() == "a1");
+    REQUIRE(calls == 1);
+
+    Any reused;
+    g.call({1, "a"}, reused);
+    auto storage = &reused.get<std::string &>();
+    g.call({1, "a"}, reused);
+    REQUIRE(&reused.get<std::string &>() == storage);
+    REQUIRE(reused.get<std::string>() == "a1");
+    REQUIRE(calls == 1);
+  }
+
+  SECTION("uncopyable results are const"){
+    auto h = memoize([&](int a) -> Any { ++calls; return std::to_string(a); }, 2);
+    auto result = h(1);
+    REQUIRE_THROWS_AS(result.get<std::string &>(), InvalidVisitorException);
+    REQUIRE(result.get<const std::string &>() == "1");
+    result.assign<std::string>("poisoned");
+    REQUIRE(h(1).get<std::string>() == "1");
+    REQUIRE(calls == 1);
+  }
+
+  SECTION("argument types"){
+    REQUIRE(g(1, "a").get<std::string>() == "a1");
+    REQUIRE(g(1u, "a").get<std::string>() == "a1");
+    REQUIRE(calls == 2);
+  }
+
+  SECTION("least recently used"){
+    g(1, "a");
+    g(2, "a");
+    g(1, "a");
+    g(3, "a");
+    REQUIRE(calls == 3);
+    g(1, "a");
+    REQUIRE(calls == 3);
+    g(2, "a");
+    REQUIRE(calls == 4);
+  }
+
+  SECTION("unsupported arguments"){
+    struct A { int value; };
+    AnyFunction h = [&](const A &a){ ++calls; return a.value; };
+    auto m = memoize(h, 10);
+    REQUIRE(m(A{1}).get<int>() == 1);
+    REQUIRE(m(A{1}).get<int>() == 1);
+    REQUIRE(calls == 2);
+  }
+
+  SECTION("exceptions"){
+    REQUIRE_THROWS_AS(g(1), AnyFunctionInvalidArgumentCountException);
+    REQUIRE_THROWS_AS(memoize(AnyFunction(), 1), UndefinedAnyFunctionException);
+  }
+
+  SECTION("concurrent calls"){
+    auto h = memoize([&](int a){ ++calls; return a * 2; }, 100);
+    std::vector<AnyFuture> futures;
+    for (int i = 0; i < 1000; ++i) { futures.push_back(h.callAsync({i % 10})); }
+    for (int i = 0; i < 1000; ++i) { REQUIRE(futures[i].get().get<int>() == 2 * (i % 10)); }
+    int computed = calls;
+    REQUIRE(computed >= 10);
+    for (int i = 0; i < 10; ++i) { REQUIRE(h(i).get<int>() == 2 * i); }
+    REQUIRE(calls == computed);
+  }
+}
@@ -0,0 +1,182 @@
+#include <catch2/catch.hpp>
+
+#include <lars/any_function.h>
+#include <lars/shm_any_channel.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace lars;
+
+namespace {
+  std::string channelName(const std::string &suffix) {
+    return "/lars_any_channel_test_" + std::to_string(::getpid()) + "_" + suffix;
+  }
+
+  /**
+   * Runs `f` in a child process and returns its exit status.
+   */
+  template <class F> pid_t spawn(F && f) {
+    auto pid = ::fork();
+    if (pid == 0) {
+      int status = 1;
+      try { status = f(); } catch (...) { }
+      ::_exit(status);
+    }
+    return pid;
+  }
+
+  int wait(pid_t pid) {
+    int status = -1;
+    ::waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  }
+}
+
+TEST_CASE("ShmAnyChannel", "[shm_any_channel]"){
+  auto name = channelName("basic");
+
+  SECTION("single process"){
+    auto channel = ShmAnyChannel::create(name, 4, 64);
+    REQUIRE(channel.mode() == ShmAnyChannel::Mode::spsc);
+    REQUIRE(channel.slotCount() == 4);
+    REQUIRE(!channel.tryReceive([](const Any &){ }));
+
+    for (int i = 0; i < 4; ++i) { REQUIRE(channel.trySend(Any(i))); }
+    REQUIRE(!channel.trySend(Any(4)));
+
+    for (int i = 0; i < 4; ++i) {
+      REQUIRE(channel.tryReceive([&](const Any &value){ REQUIRE(value.get<int>() == i); }));
+    }
+    REQUIRE(!channel.tryReceive([](const Any &){ }));
+
+    channel.send(Any(std::string("string")));
+    channel.receive([](const Any &value){ REQUIRE(value.get<std::string>() == "string"); });
+  }
+
+  SECTION("received strings"){
+    auto channel = ShmAnyChannel::create(name, 2, 64);
+    auto other = ShmAnyChannel::open(name);
+    channel.send(Any(std::string("string")));
+    AnyFunction length = [](const std::string &value){ return value.size(); };
+    other.receive([&](const Any &value){
+      REQUIRE(value.get<const std::string &>() == "string");
+      REQUIRE(length(value).get<size_t>() == 6);
+    });
+  }
+
+  SECTION("values are views into the slot"){
+    AnySerializer serializer;
+    serializer.setStringViews(true);
+    auto channel = ShmAnyChannel::create(name, 2, 64);
+    auto other = ShmAnyChannel::open(name, serializer);
+    channel.send(Any(std::string("string")));
+    channel.send(Any(1.5));
+    other.receive([&](const Any &value){
+      REQUIRE(value.type() == getStaticTypeIndex<std::string_view>());
+      REQUIRE(value.get<std::string_view>() == "string");
+    });
+    other.receive([&](const Any &value){
+      REQUIRE(value.get<double>() == 1.5);
+    });
+  }
+
+  SECTION("errors"){
+    REQUIRE_THROWS_AS(ShmAnyChannel::create(name, 3, 64), ShmAnyChannelException);
+    REQUIRE_THROWS_AS(ShmAnyChannel::open(name), ShmAnyChannelException);
+    auto channel = ShmAnyChannel::create(name, 2, 32);
+    REQUIRE_THROWS_AS(ShmAnyChannel::create(name, 2, 32), ShmAnyChannelException);
+    REQUIRE_THROWS_AS(channel.trySend(Any(std::string(100, 'x'))), ShmAnyChannelException);
+    REQUIRE(!channel.tryReceive([](const Any &){ }));
+  }
+
+  SECTION("exceptions release the slot"){
+    auto channel = ShmAnyChannel::create(name, 1, 32);
+    channel.send(Any(1));
+    REQUIRE_THROWS(channel.tryReceive([](const Any &){ throw std::runtime_error("error"); }));
+    REQUIRE(channel.trySend(Any(2)));
+  }
+
+  SECTION("corrupt entry sizes"){
+    auto channel = ShmAnyChannel::create(name, 2, 32);
+    channel.send(Any(1));
+    channel.send(Any(2));
+
+    auto fd = ::shm_open(name.c_str(), O_RDWR, 0);
+    REQUIRE(fd >= 0);
+    auto offset = shm_any_channel_detail::roundUp(sizeof(shm_any_channel_detail::Header), shm_any_channel_detail::cacheLine);
+    auto memory = ::mmap(nullptr, offset + sizeof(shm_any_channel_detail::SlotHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    REQUIRE(memory != MAP_FAILED);
+    auto &slot = *reinterpret_cast<shm_any_channel_detail::SlotHeader *>(static_cast<char *>(memory) + offset);
+    slot.size = uint64_t(1) << 40;
+
+    REQUIRE_THROWS_AS(channel.tryReceive([](const Any &){ }), ShmAnyChannelException);
+    REQUIRE(channel.tryReceive([](const Any &value){ REQUIRE(value.get<int>() == 2); }));
+    REQUIRE(channel.trySend(Any(3)));
+    ::munmap(memory, offset + sizeof(shm_any_channel_detail::SlotHeader));
+  }
+
+  SECTION("two processes"){
+    constexpr int count = 10000;
+    auto channel = ShmAnyChannel::create(name, 16, 64);
+    auto child = spawn([&](){
+      auto sender = ShmAnyChannel::open(name);
+      for (int i = 0; i < count; ++i) {
+        if (i % 2) { sender.send(Any(i)); } else { sender.send(Any(std::to_string(i))); }
+      }
+      return 0;
+    });
+    bool valid = true;
+    for (int i = 0; i < count; ++i) {
+      channel.receive([&](const Any &value){
+        if (i % 2) { valid &= value.get<int>() == i; } else { valid &= value.get<std::string>() == std::to_string(i); }
+      });
+    }
+    REQUIRE(valid);
+    REQUIRE(wait(child) == 0);
+  }
+
+  SECTION("multiple producers and consumers"){
+    constexpr int producers = 3, consumers = 2, count = 2000;
+    auto channel = ShmAnyChannel::create(name, 8, 32, ShmAnyChannel::Mode::mpmc);
+    REQUIRE(channel.mode() == ShmAnyChannel::Mode::mpmc);
+
+    std::vector<pid_t> children;
+    for (int p = 0; p < producers; ++p) {
+      children.push_back(spawn([&, p](){
+        auto sender = ShmAnyChannel::open(name);
+        for (int i = 0; i < count; ++i) { sender.send(Any(p * count + i)); }
+        return 0;
+      }));
+    }
+
+    std::vector<std::vector<int>> received(consumers);
+    std::vector<std::thread> threads;
+    for (int c = 0; c < consumers; ++c) {
+      threads.emplace_back([&, c](){
+        auto receiver = ShmAnyChannel::open(name);
+        for (int i = 0; i < producers * count / consumers; ++i) {
+          receiver.receive([&](const Any &value){ received[c].push_back(value.get<int>()); });
+        }
+      });
+    }
+    for (auto &thread: threads) { thread.join(); }
+    for (auto child: children) { REQUIRE(wait(child) == 0); }
+
+    std::vector<int> all;
+    for (auto &values: received) { all.insert(all.end(), values.begin(), values.end()); }
+    std::sort(all.begin(), all.end());
+    REQUIRE(all.size() == producers * count);
+    for (int i = 0; i < producers * count; ++i) { REQUIRE(all[i] == i); }
+  }
+
+}
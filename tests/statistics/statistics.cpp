@@ -0,0 +1,100 @@
+#include <catch2/catch.hpp>
+
+#include <lars/any_function.h>
+#include <lars/statistics.h>
+
+#include <sstream>
+#include <string>
+#include <thread>
+
+namespace {
+  using namespace lars;
+
+  struct A: public Visitable<A> { };
+  struct B: public DerivedVisitable<B, A> { };
+  struct X: public Visitable<X> { };
+
+  struct AVisitor: public Visitor<A &> {
+    void visit(A &) override { }
+  };
+
+  const DispatchCounters * find(const Statistics &statistics, StaticTypeIndex visitable) {
+    for (auto &d: statistics.dispatches) {
+      if (d.visitableType == visitable) { return &d; }
+    }
+    return nullptr;
+  }
+}
+
+TEST_CASE("Statistics", "[statistics]"){
+  REQUIRE(statisticsEnabled);
+  resetStatistics();
+
+  A a;
+  B b;
+  X x;
+  AVisitor visitor;
+
+  SECTION("dispatches"){
+    a.accept(visitor);
+    a.accept(visitor);
+    b.accept(visitor);
+    REQUIRE_THROWS_AS(x.accept(visitor), InvalidVisitorException);
+
+    auto statistics = getStatistics();
+    REQUIRE(statistics.dispatches.size() == 3);
+    REQUIRE(statistics.dispatches[0].visitableType == getStaticTypeIndex<A>());
+
+    auto counters = find(statistics, getStaticTypeIndex<A>());
+    REQUIRE(counters);
+    REQUIRE(counters->visitorType == visitor.visitorType());
+    REQUIRE(counters->hits == 2);
+    REQUIRE(counters->misses == 0);
+    REQUIRE(counters->averageProbes() == Approx(1));
+
+    counters = find(statistics, getStaticTypeIndex<B>());
+    REQUIRE(counters);
+    REQUIRE(counters->hits == 1);
+    REQUIRE(counters->maxProbes == 2);
+
+    counters = find(statistics, getStaticTypeIndex<X>());
+    REQUIRE(counters);
+    REQUIRE(counters->hits == 0);
+    REQUIRE(counters->misses == 1);
+    REQUIRE(statistics.invalidVisitorExceptions == 1);
+
+    std::stringstream stream;
+    statistics.dump(stream);
+    REQUIRE(stream.str().find("invalid visitor exceptions: 1") != std::string::npos);
+  }
+
+  SECTION("Any and AnyFunction"){
+    Any value = 1;
+    value.assign<int>(2);
+    AnyFunction f = [](int v){ return v; };
+    f(value);
+    auto statistics = getStatistics();
+    // the result of `f` is stored in a new Any
+    REQUIRE(statistics.anyAllocations == 2);
+    REQUIRE(statistics.anyFunctionCalls == 1);
+  }
+
+  SECTION("threads"){
+    std::thread thread([&](){
+      for (int i = 0; i < 10; ++i) { a.accept(visitor); }
+    });
+    thread.join();
+    a.accept(visitor);
+    auto counters = find(getStatistics(), getStaticTypeIndex<A>());
+    REQUIRE(counters);
+    REQUIRE(counters->hits == 11);
+  }
+
+  SECTION("reset"){
+    a.accept(visitor);
+    resetStatistics();
+    auto statistics = getStatistics();
+    REQUIRE(!find(statistics, getStaticTypeIndex<B>()));
+    REQUIRE(!find(statistics, getStaticTypeIndex<A>()));
+  }
+}
@@ -0,0 +1,108 @@
+#include <catch2/catch.hpp>
+
+#include <lars/thread_pool.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+using namespace lars;
+
+TEST_CASE("ThreadPool", "[thread_pool]"){
+  ThreadPool pool(4);
+  REQUIRE(pool.size() == 4);
+  REQUIRE(!pool.isWorkerThread());
+
+  SECTION("push"){
+    std::atomic<int> count{0};
+    {
+      ThreadPool local(2);
+      for (int i = 0; i < 100; ++i) { local.push([&](){ ++count; }); }
+    }
+    REQUIRE(count == 100);
+  }
+
+  SECTION("forEach"){
+    std::vector<int> values(1000);
+    pool.forEach(values.size(), [&](size_t i){ values[i] = int(i); });
+    for (size_t i = 0; i < values.size(); ++i) { REQUIRE(values[i] == int(i)); }
+  }
+
+  SECTION("nested forEach"){
+    std::atomic<int> count{0};
+    pool.forEach(16, [&](size_t){
+      pool.forEach(16, [&](size_t){ ++count; });
+    });
+    REQUIRE(count == 256);
+  }
+
+  SECTION("exceptions"){
+    REQUIRE_THROWS_AS(pool.forEach(10, [](size_t i){ if (i == 5) { throw std::runtime_error("error"); } }), std::runtime_error);
+  }
+
+  SECTION("capacity"){
+    REQUIRE(pool.getCapacity() == ThreadPool::defaultCapacity);
+    std::promise<void> release;
+    auto released = release.get_future().share();
+    std::promise<void> started;
+
+    SECTION("run in caller"){
+      ThreadPool bounded(1, 2);
+      REQUIRE(bounded.getCapacity() == 2);
+      bounded.push([&](){ started.set_value(); released.wait(); });
+      started.get_future().wait();
+      std::atomic<int> count{0};
+      std::thread::id runner;
+      bounded.push([&](){ ++count; });
+      bounded.push([&](){ ++count; });
+      bounded.push([&](){ runner = std::this_thread::get_id(); ++count; });
+      REQUIRE(count == 1);
+      REQUIRE(runner == std::this_thread::get_id());
+      release.set_value();
+      while (count < 3) { std::this_thread::yield(); }
+    }
+
+    SECTION("block"){
+      ThreadPool bounded(1, 1, ThreadPool::Overflow::block);
+      bounded.push([&](){ started.set_value(); released.wait(); });
+      started.get_future().wait();
+      std::atomic<int> count{0};
+      bounded.push([&](){ ++count; });
+      std::atomic<bool> pushed{false};
+      std::thread producer([&](){
+        bounded.push([&](){ ++count; });
+        pushed = true;
+      });
+      std::this_thread::sleep_for(std::chrono::milliseconds(50));
+      REQUIRE(!pushed);
+      release.set_value();
+      producer.join();
+      REQUIRE(pushed);
+      while (count < 2) { std::this_thread::yield(); }
+    }
+  }
+
+  SECTION("helpUntil"){
+    ThreadPool single(1);
+    std::mutex mutex;
+    std::condition_variable condition;
+    bool ready = false;
+    std::promise<void> waiting;
+    std::promise<void> done;
+    single.push([&](){
+      std::unique_lock<std::mutex> lock(mutex);
+      waiting.set_value();
+      single.helpUntil(lock, condition, [&](){ return ready; });
+      done.set_value();
+    });
+    waiting.get_future().wait();
+    // the task can only be run by the waiting worker
+    single.push([&](){
+      std::lock_guard<std::mutex> lock(mutex);
+      ready = true;
+      condition.notify_all();
+    });
+    done.get_future().wait();
+  }
+}
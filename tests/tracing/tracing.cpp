@@ -0,0 +1,116 @@
+#include <catch2/catch.hpp>
+
+#include <lars/any_function.h>
+#include <lars/tracing.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+  using namespace lars;
+
+  struct A: public Visitable<A> { };
+  struct X: public Visitable<X> { };
+
+  struct AVisitor: public Visitor<A &> {
+    void visit(A &) override { }
+    void visitDefault(const VisitableBase &) override { }
+  };
+
+  struct RecordingHook: public TraceHook {
+    std::string events;
+    void beginVisit(const TypeIndex &visitable, const TypeIndex &) override { events += visitable == getStaticTypeIndex<A>() ? "(A" : "(?"; }
+    void endVisit(const TypeIndex &, const TypeIndex &) override { events += ")"; }
+    void beginCall(const AnyFunctionSignature &signature) override { events += "[" + std::to_string(signature.argumentCount); }
+    void endCall(const AnyFunctionSignature &) override { events += "]"; }
+  };
+
+  std::vector<TraceEvent> drain() {
+    std::vector<TraceEvent> events;
+    TraceBuffer::shared().drain([&](size_t, const TraceEvent &event){ events.push_back(event); });
+    return events;
+  }
+}
+
+TEST_CASE("Tracing", "[tracing]"){
+  REQUIRE(tracingEnabled);
+  REQUIRE(getTraceHook() == &TraceBuffer::shared());
+  drain();
+
+  A a;
+  X x;
+  AVisitor visitor;
+  AnyFunction f = [&](int){ a.accept(visitor); };
+
+  SECTION("buffer"){
+    a.accept(visitor);
+    f(1);
+
+    // the argument of `f` is obtained by visiting it as well
+    auto events = drain();
+    REQUIRE(events.size() == 8);
+    REQUIRE(events[0].kind == TraceEventKind::beginVisit);
+    REQUIRE(events[0].visitableType == getStaticTypeIndex<A>());
+    REQUIRE(events[0].visitorType == visitor.visitorType());
+    REQUIRE(events[1].kind == TraceEventKind::endVisit);
+    REQUIRE(events[2].kind == TraceEventKind::beginCall);
+    REQUIRE(events[2].signature.argumentCount == 1);
+    REQUIRE(events[3].kind == TraceEventKind::beginVisit);
+    REQUIRE(events[3].visitableType == getStaticTypeIndex<int>());
+    REQUIRE(events[5].visitableType == getStaticTypeIndex<A>());
+    REQUIRE(events[7].kind == TraceEventKind::endCall);
+    REQUIRE(events[0].time <= events[7].time);
+    REQUIRE(drain().empty());
+  }
+
+  SECTION("threads"){
+    std::thread thread([&](){ a.accept(visitor); });
+    thread.join();
+    a.accept(visitor);
+    std::vector<size_t> threads;
+    TraceBuffer::shared().drain([&](size_t thread, const TraceEvent &){ threads.push_back(thread); });
+    REQUIRE(threads.size() == 4);
+    REQUIRE(threads[0] != threads[3]);
+  }
+
+  SECTION("asynchronous call"){
+    f.callAsync({1}).wait();
+    std::vector<std::pair<size_t, TraceEvent>> events;
+    TraceBuffer::shared().drain([&](size_t thread, const TraceEvent &event){ events.emplace_back(thread, event); });
+    REQUIRE(events.size() == 6);
+    REQUIRE(events[0].second.kind == TraceEventKind::beginCall);
+    REQUIRE(events[4].second.kind == TraceEventKind::endVisit);
+    REQUIRE(events[5].second.kind == TraceEventKind::endCall);
+    for (auto &event: events) { REQUIRE(event.first == events[0].first); }
+  }
+
+  SECTION("full buffer"){
+    auto dropped = TraceBuffer::shared().dropped();
+    for (size_t i = 0; i < LARS_VISITOR_TRACE_BUFFER_SIZE; ++i) { a.accept(visitor); }
+    REQUIRE(drain().size() == LARS_VISITOR_TRACE_BUFFER_SIZE);
+    REQUIRE(TraceBuffer::shared().dropped() == dropped + LARS_VISITOR_TRACE_BUFFER_SIZE);
+  }
+
+  SECTION("custom hook"){
+    RecordingHook hook;
+    setTraceHook(&hook);
+    a.accept(visitor);
+    x.accept(visitor);
+    f(1);
+    setTraceHook(nullptr);
+    a.accept(visitor);
+    setTraceHook(&TraceBuffer::shared());
+    REQUIRE(hook.events == "(A)(?)[1(?)(A)]");
+    REQUIRE(drain().empty());
+  }
+
+  SECTION("exporter"){
+    size_t count = 0;
+    {
+      TraceExporter exporter([&](size_t, const TraceEvent &){ ++count; });
+      a.accept(visitor);
+    }
+    REQUIRE(count == 2);
+  }
+}
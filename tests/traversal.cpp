@@ -0,0 +1,139 @@
+#include <catch2/catch.hpp>
+
+#include <lars/traversal.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+  using namespace lars;
+
+  struct Node: public Visitable<Node> {
+    char name;
+    std::vector<Node *> children;
+    Node(char n):name(n){ }
+  };
+
+  void getChildren(VisitableBase &node, std::vector<VisitableBase *> &children) {
+    for (auto child: visitor_cast<Node &>(node).children) { children.push_back(child); }
+  }
+
+  struct NameVisitor: public RecursiveVisitor<Node &> {
+    std::mutex mutex;
+    std::string result;
+    char prune = 0;
+
+    bool visit(Node &node) override {
+      std::lock_guard<std::mutex> lock(mutex);
+      result += node.name;
+      return node.name == prune;
+    }
+  };
+}
+
+TEST_CASE("Traversal", "[traversal]"){
+  //     a
+  //   b   c
+  //  d e   f
+  Node a('a'), b('b'), c('c'), d('d'), e('e'), f('f');
+  a.children = {&b, &c};
+  b.children = {&d, &e};
+  c.children = {&f};
+
+  NameVisitor visitor;
+  Traversal traversal(getChildren);
+
+  SECTION("pre-order"){
+    REQUIRE(traversal.run(a, visitor) == 6);
+    REQUIRE(visitor.result == "abdecf");
+  }
+
+  SECTION("post-order"){
+    traversal.setOrder(TraversalOrder::postOrder);
+    REQUIRE(traversal.run(a, visitor) == 6);
+    REQUIRE(visitor.result == "debfca");
+  }
+
+  SECTION("breadth-first"){
+    traversal.setOrder(TraversalOrder::breadthFirst);
+    REQUIRE(traversal.run(a, visitor) == 6);
+    REQUIRE(visitor.result == "abcdef");
+  }
+
+  SECTION("pruning"){
+    visitor.prune = 'b';
+    REQUIRE(traversal.run(a, visitor) == 4);
+    REQUIRE(visitor.result == "abcf");
+    visitor.result.clear();
+    traversal.setOrder(TraversalOrder::breadthFirst);
+    REQUIRE(traversal.run(a, visitor) == 4);
+    REQUIRE(visitor.result == "abcf");
+  }
+
+  SECTION("DAG"){
+    c.children.push_back(&e);
+    REQUIRE(traversal.run(a, visitor) == 7);
+    REQUIRE(visitor.result == "abdecfe");
+    visitor.result.clear();
+    traversal.setDeduplicate(true);
+    REQUIRE(traversal.run(a, visitor) == 6);
+    REQUIRE(visitor.result == "abdecf");
+  }
+
+  SECTION("DAG post-order"){
+    // a -> [b, c], b -> [c]
+    a.children = {&b, &c};
+    b.children = {&c};
+    c.children = {};
+    traversal.setOrder(TraversalOrder::postOrder).setDeduplicate(true);
+    REQUIRE(traversal.run(a, visitor) == 3);
+    REQUIRE(visitor.result == "cba");
+    visitor.result.clear();
+    c.children = {&f};
+    f.children = {&b};
+    REQUIRE(traversal.run(a, visitor) == 4);
+    REQUIRE(visitor.result == "fcba");
+  }
+
+  SECTION("cycle"){
+    f.children.push_back(&a);
+    traversal.setDeduplicate(true);
+    for (auto order: {TraversalOrder::preOrder, TraversalOrder::postOrder, TraversalOrder::breadthFirst}) {
+      visitor.result.clear();
+      REQUIRE(traversal.setOrder(order).run(a, visitor) == 6);
+      REQUIRE(visitor.result.size() == 6);
+    }
+  }
+
+  SECTION("parallel"){
+    ThreadPool pool(4);
+    for (auto order: {TraversalOrder::preOrder, TraversalOrder::postOrder, TraversalOrder::breadthFirst}) {
+      visitor.result.clear();
+      REQUIRE(traversal.setOrder(order).runParallel(a, visitor, pool) == 6);
+      std::sort(visitor.result.begin(), visitor.result.end());
+      REQUIRE(visitor.result == "abcdef");
+    }
+    c.children.push_back(&e);
+    visitor.result.clear();
+    REQUIRE(traversal.setOrder(TraversalOrder::preOrder).setDeduplicate(true).runParallel(a, visitor, pool) == 6);
+    visitor.result.clear();
+    visitor.prune = 'a';
+    REQUIRE(traversal.runParallel(a, visitor, pool) == 1);
+  }
+}
+
+TEST_CASE("Traversal of deep graphs", "[traversal]"){
+  std::vector<std::unique_ptr<Node>> nodes;
+  for (size_t i = 0; i < 1000000; ++i) {
+    nodes.push_back(std::make_unique<Node>('n'));
+    if (i > 0) { nodes[i - 1]->children.push_back(nodes[i].get()); }
+  }
+
+  NameVisitor visitor;
+  Traversal traversal(getChildren, TraversalOrder::postOrder);
+  REQUIRE(traversal.run(*nodes.front(), visitor) == nodes.size());
+  REQUIRE(visitor.result.size() == nodes.size());
+}
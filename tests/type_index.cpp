@@ -26,4 +26,25 @@ TEST_CASE("Type Index") {
   REQUIRE(lars::stream_to_string(getTypeIndex<A>()) == "int");
   REQUIRE(lars::stream_to_string(getTypeIndex<B>()) == "float");
 
+  REQUIRE(getTypeIndex<A>().nameView() == "int");
+  REQUIRE(getTypeIndex<A>().nameView() == getTypeIndex<A>().name());
+  REQUIRE(get_type_name<B>() == "float");
+
+}
+
+template <typename ...> struct List {};
+
+TEST_CASE("Pretty Type Name") {
+
+  using namespace lars;
+
+  REQUIRE(type_index_detail::normalizeTypeName("TypeList<int &,const float &>") == "TypeList<int&, const float&>");
+  REQUIRE(type_index_detail::normalizeTypeName("TypeList<int&, const float&>") == "TypeList<int&, const float&>");
+  REQUIRE(type_index_detail::normalizeTypeName("TypeList< A<B> >") == "TypeList<A<B>>");
+
+  auto name = getPrettyTypeName<List<int &, const float &>>();
+  REQUIRE(name.find("int&, const float&") != std::string_view::npos);
+  REQUIRE(getPrettyTypeName<List<int &, const float &>>().data() == name.data());
+  REQUIRE(getPrettyTypeName<int>() == "int");
+
 }
@@ -0,0 +1,111 @@
+#include <catch2/catch.hpp>
+
+#include <lars/type_map.h>
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace lars;
+
+namespace {
+  template <size_t I> struct Key {};
+
+  template <size_t ... I> std::vector<StaticTypeIndex> makeKeys(std::index_sequence<I...>) {
+    return std::vector<StaticTypeIndex>{ getStaticTypeIndex<Key<I>>()... };
+  }
+}
+
+TEST_CASE("TypeMap", "[type_map]"){
+  TypeMap<std::string> map;
+  REQUIRE(map.empty());
+  REQUIRE(map.find(getStaticTypeIndex<int>()) == nullptr);
+
+  REQUIRE(map.emplace(getStaticTypeIndex<int>(), "int").second);
+  REQUIRE(!map.emplace(getStaticTypeIndex<int>(), "other").second);
+  map[getStaticTypeIndex<float>()] = "float";
+  map.set(getStaticTypeIndex<double>(), "double");
+
+  auto check = [&](){
+    REQUIRE(map.size() == 3);
+    REQUIRE(map.contains(getStaticTypeIndex<int>()));
+    REQUIRE(!map.contains(getStaticTypeIndex<char>()));
+    REQUIRE(*map.find(getStaticTypeIndex<int>()) == "int");
+    REQUIRE(map.at(getStaticTypeIndex<float>()) == "float");
+    REQUIRE(map.at(getStaticTypeIndex<double>()) == "double");
+    REQUIRE_THROWS_AS(map.at(getStaticTypeIndex<char>()), std::out_of_range);
+    size_t count = 0;
+    for (auto & entry: map) {
+      REQUIRE(map.at(entry.first) == entry.second);
+      ++count;
+    }
+    REQUIRE(count == 3);
+  };
+
+  SECTION("mutable"){
+    check();
+    map.set(getStaticTypeIndex<double>(), "f64");
+    REQUIRE(map.at(getStaticTypeIndex<double>()) == "f64");
+    REQUIRE(map.erase(getStaticTypeIndex<int>()));
+    REQUIRE(!map.erase(getStaticTypeIndex<int>()));
+    REQUIRE(map.find(getStaticTypeIndex<int>()) == nullptr);
+    REQUIRE(map.at(getStaticTypeIndex<float>()) == "float");
+    REQUIRE(map.size() == 2);
+    map.clear();
+    REQUIRE(map.empty());
+    REQUIRE(!map.contains(getStaticTypeIndex<float>()));
+  }
+
+  SECTION("frozen"){
+    map.freeze();
+    REQUIRE(map.isFrozen());
+    check();
+    REQUIRE_THROWS_AS(map.emplace(getStaticTypeIndex<char>(), "char"), FrozenTypeMapException);
+    REQUIRE_THROWS_AS(map.set(getStaticTypeIndex<char>(), "char"), FrozenTypeMapException);
+    REQUIRE_THROWS_AS(map[getStaticTypeIndex<char>()], FrozenTypeMapException);
+    REQUIRE_THROWS_AS(map.erase(getStaticTypeIndex<int>()), FrozenTypeMapException);
+    REQUIRE_NOTHROW(map.freeze());
+    check();
+    REQUIRE(!map.emplace(getStaticTypeIndex<int>(), "other").second);
+    REQUIRE(map[getStaticTypeIndex<int>()] == "int");
+    map[getStaticTypeIndex<int>()] = "i32";
+    REQUIRE(map.set(getStaticTypeIndex<float>(), "f32") == "f32");
+    REQUIRE(map.at(getStaticTypeIndex<int>()) == "i32");
+    REQUIRE(map.at(getStaticTypeIndex<float>()) == "f32");
+    REQUIRE(map.size() == 3);
+  }
+}
+
+TEST_CASE("TypeMap random operations", "[type_map]"){
+  auto keys = makeKeys(std::make_index_sequence<300>());
+  TypeMap<size_t> map;
+  std::unordered_map<StaticTypeIndex, size_t> reference;
+  std::mt19937 random(42);
+
+  for (size_t i = 0; i < 20000; ++i) {
+    auto & key = keys[random() % keys.size()];
+    if (random() % 3 == 0) {
+      REQUIRE(map.erase(key) == (reference.erase(key) == 1));
+    } else {
+      map.set(key, i);
+      reference[key] = i;
+    }
+    if (i % 1000 == 0) {
+      REQUIRE(map.size() == reference.size());
+      for (auto & k: keys) {
+        auto it = reference.find(k);
+        auto v = map.find(k);
+        REQUIRE((it == reference.end()) == (v == nullptr));
+        if (v) { REQUIRE(*v == it->second); }
+      }
+    }
+  }
+
+  map.freeze();
+  REQUIRE(map.size() == reference.size());
+  for (auto & entry: reference) {
+    REQUIRE(map.at(entry.first) == entry.second);
+  }
+}
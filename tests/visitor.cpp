@@ -218,6 +218,7 @@ TEST_CASE("visitor_inheritance", "[visitor]") {
     REQUIRE(visitor.getTypeName(*c) == 'C');
     REQUIRE_THROWS_AS(visitor.getTypeName(*x), InvalidVisitorException);
     REQUIRE_THROWS_WITH(visitor.getTypeName(*x), Catch::Matchers::Contains("X") && Catch::Matchers::Contains("invalid visitor"));
+    REQUIRE(InvalidVisitorException(x->visitableType(), visitor.visitorType()).what() == InvalidVisitorException(x->visitableType(), visitor.visitorType()).what());
     REQUIRE(visitor.getTypeName(*d) == 'A');
     REQUIRE(visitor.getTypeName(*e) == 'A');
     REQUIRE(visitor.getTypeName(*f) == 'B');
@@ -286,11 +287,13 @@ template <class T, class V, class P> void testVisitorCastAs(V & v, P * p) {
     REQUIRE(visitor_cast<const T *>(&v) == p);
     REQUIRE(visitor_cast<const T *>(nullptr) == nullptr);
     REQUIRE(&visitor_cast<const T &>(v) == p);
+    REQUIRE(isA<T>(v));
   } else {
     REQUIRE(visitor_cast<T*>(&v) == nullptr);
     REQUIRE_THROWS(visitor_cast<T&>(v));
     REQUIRE(visitor_cast<const T *>(&v) == nullptr);
     REQUIRE_THROWS(visitor_cast<const T &>(v));
+    REQUIRE(!isA<T>(v));
   }
 }
 
@@ -314,6 +317,33 @@ TEST_CASE("SharedVisitorCast", "[visitor]"){
   REQUIRE(visitor_pointer_cast<B>(t) == std::shared_ptr<B>());
 }
 
+TEST_CASE("visitor_default", "[visitor]") {
+  struct AVisitor: public lars::Visitor<const A &> {
+    std::string result;
+
+    void visit(const A &v) override {
+      result += v.name;
+    }
+
+    void visitDefault(const VisitableBase &v) override {
+      result += v.visitableType() == getTypeIndex<X>() ? 'X' : '?';
+    }
+  };
+
+  AVisitor visitor;
+  A a;
+  C c;
+  X x;
+  EmptyVisitable empty;
+
+  REQUIRE_NOTHROW(x.accept(visitor));
+  REQUIRE_NOTHROW(std::as_const(x).accept(visitor));
+  a.accept(visitor);
+  c.accept(visitor);
+  empty.accept(visitor);
+  REQUIRE(visitor.result == "XXAA?");
+}
+
 TEST_CASE("Empty Visitable", "[visitor]"){
   EmptyVisitable v;
   REQUIRE_THROWS_AS(visitor_cast<int>(v), InvalidVisitorException);
@@ -321,6 +351,8 @@ TEST_CASE("Empty Visitable", "[visitor]"){
   REQUIRE_THROWS_AS(visitor_cast<int>(std::as_const(v)), InvalidVisitorException);
   REQUIRE(visitor_cast<const  int *>(&std::as_const(v)) == nullptr);
   REQUIRE(v.visitableType() == getTypeIndex<void>());
+  REQUIRE(!isA<int>(v));
+  REQUIRE(v.visitableTypeSet().size() == 0);
   
   SECTION("Visitor"){
     Visitor<> visitor;